@@ -0,0 +1,582 @@
+// Synthetic MPE workloads for the headless core.
+//
+// Measures the stages that run per note event and per frame:
+//   listener  - what the MPEInstrument listener does on the audio thread (pitch conversion + queue push)
+//   apply     - draining the queue into the IntensityModel on the message thread
+//   frame     - IntensityModel::update, pitch-class aggregation and per-tile lookups (PluginEditor::updateTiles)
+//   tuning    - rebuilding the descriptor table and lattice index after a tuning parameter change
+//   harmony   - HarmonyAnalyzer on the held pitches whenever they change, as the harmony worker does
+//
+// A separate harmony sweep measures the analysis of single chords at 3 to 2048 held pitches,
+// both doubled chord tones (which are matched against the chord templates) and microtonal
+// clusters (which merge into many pitch classes).
+//
+// PluginProcessor::processBlock and the tile paint need JUCE and aren't covered here.
+//
+// The --json output lists, per workload and stage, the number of items (events for listener
+// and apply, tiles for tuning, frames for frame), mean ns per item, per-sample p50/p99/max
+// in ms and the number of heap allocations. The harmony sweep lists the same per polyphony.
+//
+// --stress runs only the high polyphony workloads, at 256, 1024 and 2048 voices (the VoiceTable
+// capacity), and fails with exit code 1 unless every one of them keeps apply plus frame under
+// stressBudgetMs at p99 without dropping an event or a voice.
+//
+// Usage: MidiVisBenchmarks [--json <file>] [--frames <n>] [--stress]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "HarmonyAnalyzer.h"
+#include "IntensityModel.h"
+#include "LatticeIndex.h"
+#include "NoteEventQueue.h"
+#include "PerformanceHistory.h"
+#include "Pitch.h"
+#include "PitchClassIntensities.h"
+
+namespace {
+std::atomic<uint64_t> numAllocations(0);
+
+// Kept out of line: once inlined into a delete expression, GCC takes the free() for a
+// mismatch with the new expression that allocated the pointer
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+void release(void* p) noexcept
+{
+	std::free(p);
+}
+}
+
+void* operator new(std::size_t size)
+{
+	numAllocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	release(p);
+}
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+const double frameIntervalMs = 1000.0 / 60.0;
+// Share of a 60 Hz frame the core may take in --stress, leaving the rest for painting
+const double stressBudgetMs = frameIntervalMs / 4;
+
+struct Stats
+{
+	std::vector<double> samples;
+	uint64_t allocations = 0;
+	uint64_t count = 0;
+
+	double total() const
+	{
+		double sum = 0;
+		for (double sample : samples) sum += sample;
+		return sum;
+	}
+
+	double percentile(double p) const
+	{
+		if (samples.empty()) return 0;
+		std::vector<double> sorted = samples;
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[(size_t)std::lround(p * (sorted.size() - 1))];
+	}
+
+	double max() const
+	{
+		return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+	}
+};
+
+// Scoped timer adding elapsed nanoseconds and allocations to a Stats
+class Measure
+{
+public:
+	Measure(Stats& stats, uint64_t count = 1) :
+		stats(stats), count(count), allocationsAtStart(numAllocations.load()), start(Clock::now()) {}
+	~Measure()
+	{
+		const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		// Before recording the sample, whose vector may grow
+		stats.allocations += numAllocations.load() - allocationsAtStart;
+		stats.samples.push_back(ns);
+		stats.count += count;
+	}
+private:
+	Stats& stats;
+	uint64_t count;
+	uint64_t allocationsAtStart;
+	Clock::time_point start;
+};
+
+// The same 9 x 13 x 3 grid the editor builds
+std::vector<LatticeCoordinates> createCellBases()
+{
+	std::vector<LatticeCoordinates> cellBases;
+	for (int x = 0; x <= 8; x++)
+	{
+		for (int y = 0; y <= 12; y++)
+		{
+			for (int factor7 : { 0, 1, -1 })
+				cellBases.push_back(LatticeCoordinates{ -(y - 6), x - 4, factor7 });
+		}
+	}
+	return cellBases;
+}
+
+double midiToFreqHz(double midiPitch)
+{
+	return 440.0 * std::pow(2.0, (midiPitch - 69.0) / 12.0);
+}
+
+struct Context;
+
+// A workload generates the note events for one millisecond of playing
+struct Workload
+{
+	const char* name;
+	const char* description;
+	std::function<void(Context&, int ms)> tick;
+	bool dragTuning;
+};
+
+struct Context
+{
+	NoteEventQueue queue;
+	// What the processor records alongside the queue, and a model to rebuild past states into
+	std::unique_ptr<PerformanceHistory> history = std::make_unique<PerformanceHistory>(0.0);
+	IntensityModel seekModel;
+	IntensityModel model;
+	PitchClassIntensities pitchClassIntensities;
+	std::vector<LatticeCoordinates> cellBases;
+	std::shared_ptr<const DescriptorTable> descriptors;
+	LatticeIndex latticeIndex;
+	std::vector<PitchInfo> tileIntensities;
+	HarmonyAnalyzer harmonyAnalyzer;
+	std::vector<int32_t> heldPitchKeys;
+	std::mt19937 random;
+	// noteID and pitch of every sounding voice
+	std::vector<std::pair<uint16_t, double>> voices;
+	uint16_t nextNoteID = 0;
+	double timeSeconds = 0;
+
+	Stats listener;
+	Stats apply;
+	Stats frame;
+	Stats tuning;
+	Stats record;
+	Stats seek;
+	Stats harmony;
+
+	// Stands in for the listener callback: convert the MPE note's frequency and push
+	void noteOn(double midiPitch)
+	{
+		voices.emplace_back(nextNoteID, midiPitch);
+		noteEvent(NoteEvent::Type::Added, nextNoteID++, midiPitch);
+	}
+
+	void noteOff(size_t voice)
+	{
+		noteEvent(NoteEvent::Type::Released, voices[voice].first, voices[voice].second);
+		voices.erase(voices.begin() + voice);
+	}
+
+	void noteEvent(NoteEvent::Type type, uint16_t noteID, double midiPitch)
+	{
+		const double freqHz = midiToFreqHz(midiPitch);
+		NoteEvent event;
+		{
+			Measure measure(listener);
+			event.type = type;
+			// Spread over all 16 MPE channels, as a generative patch would
+			event.midiChannel = (uint8_t)(1 + noteID % 16);
+			event.noteID = noteID;
+			event.samplePosition = 0;
+			event.midiPitch = Pitch::fromFreqHz(freqHz).getMidiPitch();
+			event.blockTimeSeconds = timeSeconds;
+			event.timeSeconds = timeSeconds;
+			queue.push(event);
+		}
+		Measure measure(record);
+		history->record(event);
+	}
+
+	void runFrame()
+	{
+		// The processor's timer does this about once a second, off the audio thread
+		history->grow();
+		{
+			Measure measure(apply, queue.getNumReady());
+			NoteEvent event;
+			while (queue.pop(event))
+				model.applyNoteEvent(event);
+		}
+		{
+			Measure measure(frame);
+			model.update(timeSeconds);
+			pitchClassIntensities.update(model.getPitchInfos());
+			latticeIndex.update(pitchClassIntensities);
+			for (int cell : latticeIndex.getChangedCells())
+				tileIntensities[cell] = latticeIndex.getIntensity(cell);
+		}
+
+		const VoiceTable& held = model.getVoices();
+		bool changed = (int)heldPitchKeys.size() != held.getNumHeldPitches();
+		for (int i = 0; i < held.getNumHeldPitches() && !changed; i++)
+			changed = heldPitchKeys[(size_t)i] != held.getHeldPitch(i).getKey();
+		if (changed)
+		{
+			heldPitchKeys.clear();
+			for (int i = 0; i < held.getNumHeldPitches(); i++)
+				heldPitchKeys.push_back(held.getHeldPitch(i).getKey());
+			Measure measure(harmony);
+			harmonyAnalyzer.analyze(heldPitchKeys);
+		}
+	}
+
+	// Scrubbing the timeline to a random instant so far
+	void seekToRandomTime()
+	{
+		std::uniform_real_distribution<double> seekTime(0.0, timeSeconds);
+		const double seekSeconds = seekTime(random);
+		Measure measure(seek);
+		history->reconstruct(seekSeconds, seekModel);
+		seekModel.update(seekSeconds);
+	}
+
+	// What PluginEditor::rebuildDescriptors does once per frame after a tuning change
+	void retune(double centsFactor3)
+	{
+		Measure measure(tuning, cellBases.size());
+		descriptors = DescriptorTable::build(cellBases,
+			TuningParameters{ 0, 0, 0, 0, 0, centsFactor3 * 0.01, 4.0, 10.0, 6.0, 0.001, 0 }, descriptors.get());
+		latticeIndex.rebuild(*descriptors);
+		harmonyAnalyzer.setTuning(centsFactor3 * 0.01, 4.0, 10.0, 6.0, 0.001);
+	}
+};
+
+// 10-note chords, changing every 20 ms, so 1000 note on/off events per second
+void chordTick(Context& context, int ms)
+{
+	if (ms % 20 != 0) return;
+	while (!context.voices.empty())
+		context.noteOff(context.voices.size() - 1);
+
+	std::uniform_int_distribution<int> root(36, 72);
+	const int chordRoot = root(context.random);
+	for (int i = 0; i < 10; i++)
+		context.noteOn(chordRoot + (i * 7) % 24);
+}
+
+// 128 microtonal voices sounding at once, one voice replaced every millisecond
+void clusterTick(Context& context, int ms)
+{
+	std::uniform_real_distribution<double> pitch(24.0, 108.0);
+	if (ms == 0)
+	{
+		for (int i = 0; i < 128; i++)
+			context.noteOn(pitch(context.random));
+		return;
+	}
+	context.noteOff(0);
+	context.noteOn(pitch(context.random));
+}
+
+// 16 voices, each bending by a sine of +/-2 semitones, one bend message per voice every 4 ms
+void bendTick(Context& context, int ms)
+{
+	if (ms == 0)
+	{
+		for (int i = 0; i < 16; i++)
+			context.noteOn(48.0 + i * 3);
+		return;
+	}
+	if (ms % 4 != 0) return;
+	for (size_t i = 0; i < context.voices.size(); i++)
+	{
+		const double bend = 2.0 * std::sin(ms * 0.002 * (i + 1));
+		context.noteEvent(NoteEvent::Type::PitchbendChanged, context.voices[i].first, context.voices[i].second + bend);
+	}
+}
+
+// numVoices microtonal voices across all channels, all started at once. Every millisecond one
+// is replaced, and every 4 ms 16 of them bend.
+void stressTick(Context& context, int ms, int numVoices)
+{
+	std::uniform_real_distribution<double> pitch(12.0, 120.0);
+	std::uniform_int_distribution<size_t> voice(0, (size_t)numVoices - 1);
+	if (ms == 0)
+	{
+		for (int i = 0; i < numVoices; i++)
+			context.noteOn(pitch(context.random));
+		return;
+	}
+	context.noteOff(voice(context.random));
+	context.noteOn(pitch(context.random));
+	if (ms % 4 != 0) return;
+	for (int i = 0; i < 16; i++)
+	{
+		const size_t bent = voice(context.random);
+		context.voices[bent].second += 0.25 * std::sin(ms * 0.01);
+		context.noteEvent(NoteEvent::Type::PitchbendChanged, context.voices[bent].first, context.voices[bent].second);
+	}
+}
+
+struct HarmonyResult
+{
+	int numPitches;
+	bool microtonal;
+	Stats stats;
+};
+
+// Analyses chords of numPitches held pitches in 12-EDO: a random seventh chord's tones doubled
+// across the keyboard, or pitches anywhere on it with random cent offsets
+Stats measureHarmony(int numPitches, bool microtonal, int numChords)
+{
+	const int chordTones[][4] = { { 0, 4, 7, 11 }, { 0, 4, 7, 10 }, { 0, 3, 7, 10 }, { 0, 3, 6, 10 } };
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int> chord(0, 3);
+	std::uniform_int_distribution<int> root(0, 11);
+	std::uniform_int_distribution<int> tone(0, 3);
+	std::uniform_int_distribution<int> octave(2, 8);
+	std::uniform_real_distribution<double> pitch(24.0, 108.0);
+
+	HarmonyAnalyzer analyzer;
+	analyzer.setTuning(7.0, 4.0, 10.0, 6.0, 0.001);
+	std::vector<int32_t> keys;
+	Stats stats;
+	for (int i = 0; i < numChords; i++)
+	{
+		keys.clear();
+		const int chordIndex = chord(random);
+		const int chordRoot = root(random);
+		for (int j = 0; j < numPitches; j++)
+		{
+			const double midiPitch = microtonal
+				? pitch(random)
+				: 12.0 * octave(random) + chordRoot + chordTones[chordIndex][j < 4 ? j : tone(random)];
+			keys.push_back(Pitch(midiPitch).getKey());
+		}
+		std::sort(keys.begin(), keys.end());
+
+		Measure measure(stats);
+		analyzer.analyze(keys);
+	}
+	return stats;
+}
+
+struct Result
+{
+	std::string name;
+	int frames;
+	Context* context;
+};
+
+void printStats(const char* stage, const Stats& stats, bool perEvent)
+{
+	if (stats.samples.empty()) return;
+	if (perEvent)
+	{
+		std::printf("  %-9s %10.1f ns/event   %8.3f allocs/event\n", stage,
+			stats.total() / std::max<uint64_t>(1, stats.count),
+			(double)stats.allocations / std::max<uint64_t>(1, stats.count));
+	}
+	else
+	{
+		std::printf("  %-9s %8.4f ms p50  %8.4f ms p99  %8.4f ms max   %8.2f allocs/frame\n", stage,
+			stats.percentile(0.5) * 1e-6, stats.percentile(0.99) * 1e-6, stats.max() * 1e-6,
+			(double)stats.allocations / stats.samples.size());
+	}
+}
+
+void writeStatsJson(FILE* file, const char* stage, const Stats& stats, bool last)
+{
+	std::fprintf(file,
+		"      \"%s\": { \"count\": %llu, \"meanNsPerItem\": %.3f, \"p50Ms\": %.6f, \"p99Ms\": %.6f, \"maxMs\": %.6f, \"allocations\": %llu }%s\n",
+		stage, (unsigned long long)stats.count, stats.total() / std::max<uint64_t>(1, stats.count),
+		stats.percentile(0.5) * 1e-6, stats.percentile(0.99) * 1e-6, stats.max() * 1e-6,
+		(unsigned long long)stats.allocations, last ? "" : ",");
+}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* jsonPath = nullptr;
+	int numFrames = 240;
+	bool stress = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+			numFrames = std::max(1, std::atoi(argv[++i]));
+		else if (std::strcmp(argv[i], "--stress") == 0)
+			stress = true;
+		else
+		{
+			std::fprintf(stderr, "Usage: %s [--json <file>] [--frames <n>] [--stress]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	auto stressWorkload = [](const char* name, const char* description, int numVoices)
+	{
+		return Workload{ name, description,
+			[numVoices](Context& context, int ms) { stressTick(context, ms, numVoices); }, false };
+	};
+	const std::vector<Workload> workloads = stress
+		? std::vector<Workload>{
+			stressWorkload("stress256", "256 voices on 16 channels, replaced and bent", 256),
+			stressWorkload("stress1024", "1024 voices on 16 channels, replaced and bent", 1024),
+			stressWorkload("stress2048", "2048 voices on 16 channels, replaced and bent", 2048),
+		}
+		: std::vector<Workload>{
+			{ "chords1k", "10-note chords at 1 kHz event rate", chordTick, false },
+			{ "cluster128", "128 microtonal voices held at once", clusterTick, false },
+			{ "bendSweep", "16 voices with per-note pitch-bend sweeps", bendTick, false },
+			stressWorkload("stress1024", "1024 voices on 16 channels, replaced and bent", 1024),
+			{ "tuningDrag", "10-note chords while the fifth is dragged", chordTick, true },
+		};
+	bool overBudget = false;
+
+	std::vector<std::unique_ptr<Context>> contexts;
+	std::vector<Result> results;
+
+	for (const Workload& workload : workloads)
+	{
+		contexts.push_back(std::make_unique<Context>());
+		Context& context = *contexts.back();
+		context.random.seed(1234);
+		context.cellBases = createCellBases();
+		context.tileIntensities.resize(context.cellBases.size());
+		context.retune(700.0);
+		context.tuning = Stats();
+
+		double nextFrameMs = 0;
+		int frame = 0;
+		for (int ms = 0; frame < numFrames; ms++)
+		{
+			context.timeSeconds = ms * 0.001;
+			workload.tick(context, ms);
+			if (ms >= nextFrameMs)
+			{
+				if (workload.dragTuning)
+					context.retune(690.0 + 20.0 * (frame % 100) / 100.0);
+				context.runFrame();
+				context.seekToRandomTime();
+				nextFrameMs += frameIntervalMs;
+				frame++;
+			}
+		}
+
+		std::printf("%s: %s (%d frames)\n", workload.name, workload.description, frame);
+		printStats("listener", context.listener, true);
+		printStats("apply", context.apply, true);
+		printStats("tuning", context.tuning, true);
+		printStats("frame", context.frame, false);
+		printStats("record", context.record, true);
+		printStats("seek", context.seek, false);
+		printStats("harmony", context.harmony, false);
+		if (context.queue.getNumDropped() > 0)
+			std::printf("  dropped   %u events\n", context.queue.getNumDropped());
+		if (context.model.getVoices().getNumDropped() > 0)
+			std::printf("  dropped   %u voices\n", context.model.getVoices().getNumDropped());
+		if (context.model.getNumEvicted() > 0)
+			std::printf("  evicted   %u fading pitches\n", context.model.getNumEvicted());
+
+		if (stress)
+		{
+			const double coreMs = (context.apply.percentile(0.99) + context.frame.percentile(0.99)) * 1e-6;
+			const bool passed = coreMs <= stressBudgetMs
+				&& context.queue.getNumDropped() == 0 && context.model.getVoices().getNumDropped() == 0;
+			std::printf("  %s: apply + frame p99 %.3f ms, budget %.3f ms\n",
+				passed ? "PASS" : "FAIL", coreMs, stressBudgetMs);
+			overBudget = overBudget || !passed;
+		}
+
+		results.push_back({ workload.name, frame, &context });
+		context.history.reset();
+	}
+
+	std::vector<HarmonyResult> harmonyResults;
+	if (!stress)
+		std::printf("harmony: one chord per analysis\n");
+	for (int numPitches : { 3, 8, 32, 128, 512, 2048 })
+	{
+		if (stress)
+			break;
+		for (bool microtonal : { false, true })
+		{
+			harmonyResults.push_back({ numPitches, microtonal, measureHarmony(numPitches, microtonal, 2000) });
+			char stage[32];
+			std::snprintf(stage, sizeof(stage), "%d%s", numPitches, microtonal ? " micro" : "");
+			printStats(stage, harmonyResults.back().stats, false);
+		}
+	}
+
+	if (jsonPath != nullptr)
+	{
+		FILE* file = std::fopen(jsonPath, "w");
+		if (file == nullptr)
+		{
+			std::fprintf(stderr, "Can't write %s\n", jsonPath);
+			return 1;
+		}
+
+		std::fprintf(file, "{\n  \"workloads\": [\n");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const Context& context = *results[i].context;
+			std::fprintf(file, "    { \"name\": \"%s\", \"frames\": %d, \"droppedEvents\": %u, \"stages\": {\n",
+				results[i].name.c_str(), results[i].frames, context.queue.getNumDropped());
+			writeStatsJson(file, "listener", context.listener, false);
+			writeStatsJson(file, "apply", context.apply, false);
+			writeStatsJson(file, "tuning", context.tuning, false);
+			writeStatsJson(file, "frame", context.frame, false);
+			writeStatsJson(file, "record", context.record, false);
+			writeStatsJson(file, "seek", context.seek, false);
+			writeStatsJson(file, "harmony", context.harmony, true);
+			std::fprintf(file, "    } }%s\n", i + 1 < results.size() ? "," : "");
+		}
+		std::fprintf(file, "  ],\n  \"harmony\": [\n");
+		for (size_t i = 0; i < harmonyResults.size(); i++)
+		{
+			const HarmonyResult& result = harmonyResults[i];
+			std::fprintf(file, "    { \"pitches\": %d, \"microtonal\": %s, \"stages\": {\n",
+				result.numPitches, result.microtonal ? "true" : "false");
+			writeStatsJson(file, "analyze", result.stats, true);
+			std::fprintf(file, "    } }%s\n", i + 1 < harmonyResults.size() ? "," : "");
+		}
+		std::fprintf(file, "  ]\n}\n");
+		std::fclose(file);
+	}
+
+	return overBudget ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+// Renders a Standard MIDI File to a PNG frame sequence, offline and faster than real time.
+//
+// The file is played through the same juce::MPEInstrument setup and IntensityModel as the plugin,
+// evaluated at each output frame's time, and each frame is drawn with LatticeRenderer into a
+// software image. Frames are rasterised and encoded on all cores.
+//
+// Usage: MidiVisOfflineRender <input.mid> <output directory>
+//            [--fps 60] [--width 650] [--height 930] [--threads n]
+//            [--fifth 700] [--third 400] [--seventh 1000] [--eleventh 600] [--tolerance 0.1]
+
+#include <JuceHeader.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "IntensityModel.h"
+#include "LabelImageCache.h"
+#include "LatticeIndex.h"
+#include "LatticeRenderer.h"
+#include "MPENoteEvents.h"
+#include "PitchClassIntensities.h"
+
+namespace {
+const int tileSize = 70;
+// Keep rendering after the last event so the final notes can fade out
+const double tailSeconds = 2.0;
+
+struct Options
+{
+	juce::File input;
+	juce::File outputDirectory;
+	double fps = 60.0;
+	int width = 0;
+	int height = 0;
+	int threads = 0;
+	double centsFactor3 = 700.0;
+	double centsFactor5 = 400.0;
+	double centsFactor7 = 1000.0;
+	double centsFactor11 = 600.0;
+	double tolerance = 0.1;
+};
+
+// Collects the note events the plugin's editor would push from its MPEInstrument callbacks,
+// stamped with the MIDI file time instead of the wall clock
+class NoteEventCollector : public juce::MPEInstrument::Listener
+{
+public:
+	void noteAdded(juce::MPENote mpeNote) override
+	{
+		add(NoteEvent::Type::Added, mpeNote);
+	}
+
+	void notePitchbendChanged(juce::MPENote mpeNote) override
+	{
+		add(NoteEvent::Type::PitchbendChanged, mpeNote);
+	}
+
+	void noteReleased(juce::MPENote mpeNote) override
+	{
+		add(NoteEvent::Type::Released, mpeNote);
+	}
+
+	double currentTime = 0.0;
+	std::vector<NoteEvent> events;
+private:
+	void add(NoteEvent::Type type, const juce::MPENote& mpeNote)
+	{
+		events.push_back(makeNoteEvent(type, mpeNote, { 0, currentTime, currentTime }));
+	}
+};
+
+// Per-thread rendering state. LabelImageCache and LatticeRenderer aren't thread safe,
+// so every worker gets its own.
+class FrameWriter
+{
+public:
+	FrameWriter(const std::vector<LatticeCell>& cells, const Options& options,
+		juce::Colour backgroundColour, juce::Colour textColour) :
+		renderer(labelImageCache),
+		cells(cells),
+		options(options),
+		backgroundColour(backgroundColour),
+		textColour(textColour)
+	{
+	}
+
+	bool write(int frameIndex, const std::vector<PitchInfo>& intensities)
+	{
+		for (size_t i = 0; i < cells.size(); i++)
+			cells[i].intensity = intensities[i];
+
+		juce::Image image(juce::Image::RGB, options.width, options.height, true, juce::SoftwareImageType());
+		{
+			juce::Graphics g(image);
+			g.fillAll(backgroundColour);
+			g.addTransform(juce::RectanglePlacement(juce::RectanglePlacement::centred).getTransformToFit(
+				LatticeRenderer::getCellsBounds(tileSize).toFloat(), image.getBounds().toFloat()));
+			renderer.draw(g, cells, textColour);
+		}
+
+		juce::File file = options.outputDirectory.getChildFile(juce::String::formatted("frame_%06d.png", frameIndex));
+		file.deleteFile();
+		juce::FileOutputStream stream(file);
+		return stream.openedOk() && png.writeImageToStream(image, stream);
+	}
+private:
+	LabelImageCache labelImageCache;
+	LatticeRenderer renderer;
+	std::vector<LatticeCell> cells;
+	const Options& options;
+	juce::Colour backgroundColour;
+	juce::Colour textColour;
+	juce::PNGImageFormat png;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options)
+{
+	std::vector<const char*> positional;
+	for (int i = 1; i < argc; i++)
+	{
+		auto value = [&](double& target)
+		{
+			if (i + 1 >= argc) return false;
+			target = std::atof(argv[++i]);
+			return true;
+		};
+		auto intValue = [&](int& target)
+		{
+			if (i + 1 >= argc) return false;
+			target = std::atoi(argv[++i]);
+			return true;
+		};
+
+		bool ok = true;
+		if (std::strcmp(argv[i], "--fps") == 0) ok = value(options.fps);
+		else if (std::strcmp(argv[i], "--width") == 0) ok = intValue(options.width);
+		else if (std::strcmp(argv[i], "--height") == 0) ok = intValue(options.height);
+		else if (std::strcmp(argv[i], "--threads") == 0) ok = intValue(options.threads);
+		else if (std::strcmp(argv[i], "--fifth") == 0) ok = value(options.centsFactor3);
+		else if (std::strcmp(argv[i], "--third") == 0) ok = value(options.centsFactor5);
+		else if (std::strcmp(argv[i], "--seventh") == 0) ok = value(options.centsFactor7);
+		else if (std::strcmp(argv[i], "--eleventh") == 0) ok = value(options.centsFactor11);
+		else if (std::strcmp(argv[i], "--tolerance") == 0) ok = value(options.tolerance);
+		else if (argv[i][0] == '-') ok = false;
+		else positional.push_back(argv[i]);
+
+		if (!ok) return false;
+	}
+
+	if (positional.size() != 2 || options.fps <= 0)
+		return false;
+
+	options.input = juce::File::getCurrentWorkingDirectory().getChildFile(positional[0]);
+	options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(positional[1]);
+
+	const juce::Rectangle<int> latticeBounds = LatticeRenderer::getCellsBounds(tileSize);
+	if (options.width <= 0) options.width = latticeBounds.getWidth();
+	if (options.height <= 0) options.height = latticeBounds.getHeight();
+	if (options.threads <= 0) options.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+	return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::fprintf(stderr,
+			"Usage: %s <input.mid> <output directory> [--fps 60] [--width w] [--height h] [--threads n]\n"
+			"       [--fifth 700] [--third 400] [--seventh 1000] [--eleventh 600] [--tolerance 0.1]\n", argv[0]);
+		return 1;
+	}
+
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+	juce::LookAndFeel& lookAndFeel = juce::LookAndFeel::getDefaultLookAndFeel();
+	lookAndFeel.setDefaultSansSerifTypefaceName("Helvetica");
+
+	juce::MidiFile midiFile;
+	{
+		juce::FileInputStream input(options.input);
+		if (!input.openedOk() || !midiFile.readFrom(input))
+		{
+			std::fprintf(stderr, "Can't read MIDI file %s\n", options.input.getFullPathName().toRawUTF8());
+			return 1;
+		}
+	}
+	midiFile.convertTimestampTicksToSeconds();
+
+	juce::MidiMessageSequence sequence;
+	for (int track = 0; track < midiFile.getNumTracks(); track++)
+		sequence.addSequence(*midiFile.getTrack(track), 0.0);
+	sequence.sort();
+
+	if (!options.outputDirectory.createDirectory())
+	{
+		std::fprintf(stderr, "Can't create %s\n", options.outputDirectory.getFullPathName().toRawUTF8());
+		return 1;
+	}
+
+	// Same MPE setup as PluginProcessor
+	juce::MPEInstrument mpeInstrument;
+	mpeInstrument.enableLegacyMode(24);
+	NoteEventCollector collector;
+	mpeInstrument.addListener(&collector);
+
+	std::vector<LatticeCell> cells = LatticeRenderer::createCells(tileSize);
+	std::vector<LatticeCoordinates> cellBases;
+	for (const LatticeCell& cell : cells)
+		cellBases.push_back(cell.base);
+	std::shared_ptr<const DescriptorTable> descriptors = DescriptorTable::build(cellBases, TuningParameters{
+		0, 0, 0, 0, 0,
+		options.centsFactor3 * 0.01, options.centsFactor5 * 0.01, options.centsFactor7 * 0.01, options.centsFactor11 * 0.01,
+		options.tolerance * 0.01, 0 });
+	for (size_t i = 0; i < cells.size(); i++)
+		cells[i].descriptor = descriptors->getDescriptor((int)i);
+
+	std::vector<std::unique_ptr<FrameWriter>> writers;
+	for (int i = 0; i < options.threads; i++)
+	{
+		writers.push_back(std::make_unique<FrameWriter>(cells, options,
+			lookAndFeel.findColour(juce::ResizableWindow::backgroundColourId),
+			lookAndFeel.findColour(juce::TextEditor::textColourId)));
+	}
+
+	IntensityModel model;
+	PitchClassIntensities pitchClassIntensities;
+	LatticeIndex latticeIndex;
+	latticeIndex.rebuild(*descriptors);
+	std::vector<PitchInfo> intensities(cells.size());
+
+	const double endTime = sequence.getEndTime() + tailSeconds;
+	const int numFrames = (int)std::ceil(endTime * options.fps);
+	// Events are applied sequentially in chunks of frames and each chunk is then rasterised in parallel
+	const int chunkSize = options.threads * 8;
+
+	std::vector<std::vector<PitchInfo>> chunk;
+	int nextEvent = 0;
+	bool failed = false;
+	const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+	for (int chunkStart = 0; chunkStart < numFrames && !failed; chunkStart += chunkSize)
+	{
+		const int chunkFrames = std::min(chunkSize, numFrames - chunkStart);
+		chunk.resize(chunkFrames);
+
+		for (int frame = 0; frame < chunkFrames; frame++)
+		{
+			const double frameTime = (chunkStart + frame) / options.fps;
+
+			while (nextEvent < sequence.getNumEvents()
+				&& sequence.getEventPointer(nextEvent)->message.getTimeStamp() <= frameTime)
+			{
+				const juce::MidiMessage& message = sequence.getEventPointer(nextEvent)->message;
+				collector.currentTime = message.getTimeStamp();
+				mpeInstrument.processNextMidiEvent(message);
+				nextEvent++;
+			}
+
+			for (const NoteEvent& event : collector.events)
+				model.applyNoteEvent(event);
+			collector.events.clear();
+
+			model.update(frameTime);
+			pitchClassIntensities.update(model.getPitchInfos());
+			latticeIndex.update(pitchClassIntensities);
+			for (int cell : latticeIndex.getChangedCells())
+				intensities[cell] = latticeIndex.getIntensity(cell);
+			chunk[frame] = intensities;
+		}
+
+		std::vector<std::thread> threads;
+		std::vector<char> results(writers.size(), 1);
+		for (size_t w = 0; w < writers.size(); w++)
+		{
+			threads.emplace_back([&, w]
+			{
+				for (int frame = (int)w; frame < chunkFrames; frame += (int)writers.size())
+				{
+					if (!writers[w]->write(chunkStart + frame, chunk[frame]))
+						results[w] = 0;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		for (char result : results)
+			failed = failed || result == 0;
+
+		std::printf("\r%d / %d frames", chunkStart + chunkFrames, numFrames);
+		std::fflush(stdout);
+	}
+
+	if (failed)
+	{
+		std::fprintf(stderr, "\nFailed to write frames to %s\n", options.outputDirectory.getFullPathName().toRawUTF8());
+		return 1;
+	}
+
+	const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+	std::printf("\nRendered %.1f s of music in %.1f s (%.1fx real time)\n",
+		endTime, elapsedSeconds, endTime / std::max(elapsedSeconds, 0.001));
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "BlockClock.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Fraction of the measured callback jitter the sample counter follows each block
+const double wallClockPull = 0.05;
+// Fraction of a late host timestamp the clock offset follows each block, to track slow drift
+const double hostClockDrift = 0.001;
+// Minimum discrepancy treated as a dropout or clock jump rather than jitter
+const double minResyncSeconds = 0.05;
+}
+
+BlockClock::BlockClock() :
+	sampleRate(44100.0),
+	blockTimeSeconds(0),
+	nextBlockStart(0),
+	hasNextBlockStart(false),
+	hostClockOffset(0),
+	hasHostClockOffset(false)
+{
+}
+
+void BlockClock::prepare(double newSampleRate)
+{
+	if (newSampleRate > 0)
+		sampleRate = newSampleRate;
+	hasNextBlockStart = false;
+	hasHostClockOffset = false;
+}
+
+void BlockClock::beginBlock(double nowSeconds, double hostTimeSeconds, int numSamples, int latencySamples)
+{
+	const double blockSeconds = numSamples / sampleRate;
+	const double resyncSeconds = std::max(minResyncSeconds, blockSeconds * 2.0);
+	double blockStart = nowSeconds;
+
+	if (hostTimeSeconds >= 0)
+	{
+		// We can only be called after the host's timestamp, never before, so the smallest
+		// difference seen is the offset between the two clocks
+		const double offset = nowSeconds - hostTimeSeconds;
+		if (!hasHostClockOffset || offset < hostClockOffset || offset - hostClockOffset > resyncSeconds)
+			hostClockOffset = offset;
+		else
+			hostClockOffset += (offset - hostClockOffset) * hostClockDrift;
+		hasHostClockOffset = true;
+
+		blockStart = hostTimeSeconds + hostClockOffset;
+	}
+	else if (hasNextBlockStart && std::abs(nowSeconds - nextBlockStart) < resyncSeconds)
+	{
+		blockStart = nextBlockStart + (nowSeconds - nextBlockStart) * wallClockPull;
+	}
+
+	nextBlockStart = blockStart + blockSeconds;
+	hasNextBlockStart = true;
+	blockTimeSeconds = blockStart + (numSamples + latencySamples) / sampleRate;
+}
+
+EventTiming BlockClock::getEventTiming(int samplePosition) const
+{
+	return { samplePosition, blockTimeSeconds, blockTimeSeconds + samplePosition / sampleRate };
+}
+
+double BlockClock::getSampleRate() const
+{
+	return sampleRate;
+}
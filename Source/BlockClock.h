@@ -0,0 +1,41 @@
+#pragma once
+
+// Where in the audio stream a MIDI event happened, and when it will be heard
+struct EventTiming
+{
+	// Offset of the event within its audio block
+	int samplePosition;
+	// When the first sample of the event's block is heard
+	double blockTimeSeconds;
+	// When the event itself is heard: blockTimeSeconds plus samplePosition at the block's sample rate
+	double timeSeconds;
+};
+
+// Maps sample positions in the current audio block to the time they come out of the speakers,
+// on the same clock the editor draws frames with.
+//
+// Block start times come from the host's callback timestamp when the playhead reports one,
+// otherwise from a sample counter that is gently pulled towards the wall clock so callback jitter
+// doesn't leak into the display. Output latency is the block itself (it plays once the previous one
+// has drained) plus whatever latency the plugin reports.
+// Audio thread only.
+class BlockClock
+{
+public:
+	BlockClock();
+	void prepare(double sampleRate);
+	// hostTimeSeconds is the host's callback time in seconds on its own clock, or negative if unknown
+	void beginBlock(double nowSeconds, double hostTimeSeconds, int numSamples, int latencySamples);
+	EventTiming getEventTiming(int samplePosition) const;
+	double getSampleRate() const;
+private:
+	double sampleRate;
+	// When the current block's first sample is heard
+	double blockTimeSeconds;
+	// Expected callback time of the next block, if the stream keeps running without gaps
+	double nextBlockStart;
+	bool hasNextBlockStart;
+	// Host clock to wall clock offset
+	double hostClockOffset;
+	bool hasHostClockOffset;
+};
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "DescriptorTable.h"
+#include "LatticeProjection.h"
+#include "Pitch.h"
+#include "ScalaMapping.h"
+
+std::shared_ptr<const DescriptorTable> DescriptorTable::build(
+	const std::vector<LatticeCoordinates>& cellBases, const TuningParameters& tuning,
+	const DescriptorTable* previous, const ScalaMapping* scale)
+{
+	auto table = std::make_shared<DescriptorTable>();
+	table->tuning = tuning;
+
+	const size_t numCells = cellBases.size();
+	table->coordinates.resize(numCells);
+	for (size_t i = 0; i < numCells; i++)
+	{
+		table->coordinates[i] = LatticeCoordinates{
+			cellBases[i].factor3 + tuning.factor3Offset,
+			cellBases[i].factor5 + tuning.factor5Offset,
+			cellBases[i].factor7 + tuning.factor7Offset,
+			cellBases[i].factor11 + tuning.factor11Offset };
+	}
+
+	// Pitch class keys of the whole grid in one tight loop the compiler can vectorise
+	std::vector<double> semitones(numCells);
+	for (size_t i = 0; i < numCells; i++)
+	{
+		const LatticeCoordinates& c = table->coordinates[i];
+		semitones[i] = tuning.semisFactor3 * c.factor3 + tuning.semisFactor5 * c.factor5
+			+ tuning.semisFactor7 * c.factor7 + tuning.semisFactor11 * c.factor11;
+	}
+
+	// These only depend on the tuning, not the cell
+	const bool meantone = TileDescriptor::isMeantone(tuning.semisFactor3, tuning.semisFactor5);
+	const LatticeProjection& projection = LatticeProjections::get(tuning.projection);
+	const bool depthOnPlane = projection.isDepthOnPlane(tuning);
+
+	// Letter names only depend on the lattice position and whether commas are shown
+	const bool reuseLetters = previous != nullptr
+		&& previous->coordinates == table->coordinates
+		&& previous->descriptors.size() == numCells
+		&& (numCells == 0 || previous->descriptors[0].meantone == meantone);
+	const bool reuseSemitones = previous != nullptr && previous->descriptors.size() == numCells;
+
+	table->descriptors.resize(numCells);
+	for (size_t i = 0; i < numCells; i++)
+	{
+		TileDescriptor& descriptor = table->descriptors[i];
+		const LatticeCoordinates& c = table->coordinates[i];
+		descriptor.pitchClass = PitchClass(Pitch(semitones[i]));
+		if (scale != nullptr)
+		{
+			const int degree = scale->find(c);
+			if (degree >= 0)
+				descriptor.pitchClass = PitchClass::fromKey(scale->getDegrees()[degree].pitchClassKey);
+		}
+		descriptor.tolerance = tuning.tolerance;
+		descriptor.meantone = meantone;
+		descriptor.duplicate = depthOnPlane && getAxis(cellBases[i], projection.depth) != 0;
+		// Cells panned past the edge keep empty labels
+		descriptor.outsideLattice = !isInLattice(c);
+		if (descriptor.outsideLattice)
+			continue;
+
+		if (reuseLetters)
+		{
+			const TileDescriptor& old = previous->descriptors[i];
+			descriptor.pitchName = old.pitchName;
+			descriptor.accidentals = old.accidentals;
+			descriptor.syntonicCommas = old.syntonicCommas;
+		}
+		else
+		{
+			descriptor.setLetterName(c.factor3, c.factor5, c.factor7, c.factor11);
+		}
+
+		if (reuseSemitones && previous->descriptors[i].pitchClass == descriptor.pitchClass)
+			descriptor.semitones = previous->descriptors[i].semitones;
+		else
+			descriptor.semitones = TileDescriptor::formatSemitones(descriptor.pitchClass);
+	}
+
+	return table;
+}
+
+bool DescriptorTable::isBuiltFrom(const std::vector<LatticeCoordinates>& cellBases, const TuningParameters& other) const
+{
+	if (!(tuning == other) || cellBases.size() != coordinates.size())
+		return false;
+	for (size_t i = 0; i < cellBases.size(); i++)
+	{
+		if (!(coordinates[i] == LatticeCoordinates{
+			cellBases[i].factor3 + tuning.factor3Offset,
+			cellBases[i].factor5 + tuning.factor5Offset,
+			cellBases[i].factor7 + tuning.factor7Offset,
+			cellBases[i].factor11 + tuning.factor11Offset }))
+			return false;
+	}
+	return true;
+}
+
+const TuningParameters& DescriptorTable::getTuning() const
+{
+	return tuning;
+}
+
+int DescriptorTable::getNumCells() const
+{
+	return (int)descriptors.size();
+}
+
+const LatticeCoordinates& DescriptorTable::getCoordinates(int cell) const
+{
+	return coordinates[cell];
+}
+
+const TileDescriptor& DescriptorTable::getDescriptor(int cell) const
+{
+	return descriptors[cell];
+}
+
+bool DescriptorTable::isInLattice(const LatticeCoordinates& c)
+{
+	return std::abs(c.factor3) <= maxFactor3 && std::abs(c.factor5) <= maxFactor5
+		&& std::abs(c.factor7) <= maxFactor7 && std::abs(c.factor11) <= maxFactor11;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "TileDescriptor.h"
+
+// Lattice coordinates of a cell: how many fifths, major thirds, harmonic sevenths and
+// undecimal tritones (11/8) from C
+struct LatticeCoordinates
+{
+	int factor3;
+	int factor5;
+	int factor7;
+	int factor11 = 0;
+
+	bool operator==(const LatticeCoordinates&) const = default;
+};
+
+// Everything the tuning controls set that affects the cells' descriptors
+struct TuningParameters
+{
+	int factor3Offset;
+	int factor5Offset;
+	int factor7Offset;
+	int factor11Offset;
+	// Index into LatticeProjections::projections, which decides the corner cells that are duplicates
+	int projection;
+	double semisFactor3;
+	double semisFactor5;
+	double semisFactor7;
+	double semisFactor11;
+	double tolerance;
+	// ScalaScale::getHash() of the imported scale, 0 without one
+	uint64_t scaleHash;
+
+	bool operator==(const TuningParameters&) const = default;
+};
+
+class ScalaMapping;
+
+// Descriptors of every lattice cell under one tuning, built in a single pass and never modified
+// afterwards, so a finished table can be published to readers by swapping one pointer.
+class DescriptorTable
+{
+public:
+	// Extent of the lattice in steps of each interval from C. Cells past it are marked
+	// outsideLattice and are neither lit nor drawn.
+	static constexpr int maxFactor3 = 50;
+	static constexpr int maxFactor5 = 20;
+	static constexpr int maxFactor7 = 3;
+	static constexpr int maxFactor11 = 3;
+
+	// Cell bases come from the tuning's projection, so their coordinate along its depth axis is
+	// the cell's layer.
+	// Labels that didn't change since the previous table are copied instead of reformatted.
+	// Cells a scale degree is mapped to take the degree's exact pitch class, so notes played in
+	// the scale match them within the usual tolerance.
+	static std::shared_ptr<const DescriptorTable> build(
+		const std::vector<LatticeCoordinates>& cellBases, const TuningParameters&,
+		const DescriptorTable* previous = nullptr, const ScalaMapping* scale = nullptr);
+
+	// Whether build() would make this same table from the cell bases and tuning
+	bool isBuiltFrom(const std::vector<LatticeCoordinates>& cellBases, const TuningParameters&) const;
+	const TuningParameters& getTuning() const;
+	int getNumCells() const;
+	// Cell base plus the tuning's offsets
+	const LatticeCoordinates& getCoordinates(int cell) const;
+	const TileDescriptor& getDescriptor(int cell) const;
+	// Whether the coordinates are within the extent above
+	static bool isInLattice(const LatticeCoordinates&);
+private:
+	TuningParameters tuning;
+	std::vector<LatticeCoordinates> coordinates;
+	std::vector<TileDescriptor> descriptors;
+};
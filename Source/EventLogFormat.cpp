@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstring>
+
+#include "EventLogFormat.h"
+
+bool EventLogFormat::Header::isValid() const
+{
+	return std::memcmp(magic, EventLogFormat::magic, sizeof(magic)) == 0
+		&& version >= 1 && version <= EventLogFormat::version
+		&& recordSize == sizeof(Record);
+}
+
+EventLogFormat::Header EventLogFormat::makeHeader(int64_t startUnixMilliseconds)
+{
+	Header header{};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.recordSize = sizeof(Record);
+	header.startUnixMilliseconds = startUnixMilliseconds;
+	header.numRecords = 0;
+	return header;
+}
+
+EventLogFormat::Record EventLogFormat::makeRecord(uint64_t microseconds, const uint8_t* data, int size, uint32_t flags)
+{
+	Record record{};
+	record.microseconds = microseconds;
+	record.size = (uint8_t)size;
+	for (int i = 0; i < size; i++)
+		record.data[i] = data[i];
+	record.flags = flags;
+	return record;
+}
+
+EventLogFormat::HeldNotes::HeldNotes()
+{
+	clear();
+}
+
+void EventLogFormat::HeldNotes::clear()
+{
+	velocities.fill(0);
+	pitchbends.fill(centredPitchbend);
+}
+
+void EventLogFormat::HeldNotes::apply(const Record& record)
+{
+	if (record.size != 3 || record.data[0] < 0x80 || record.data[0] >= 0xf0)
+		return;
+
+	const int channel = record.data[0] & 0x0f;
+	const uint8_t* data = record.data;
+	switch (data[0] & 0xf0)
+	{
+	case 0x90:
+		velocities[(size_t)(channel * 128 + (data[1] & 0x7f))] = data[2] & 0x7f;
+		break;
+	case 0x80:
+		velocities[(size_t)(channel * 128 + (data[1] & 0x7f))] = 0;
+		break;
+	case 0xe0:
+		pitchbends[(size_t)channel] = (uint16_t)((data[1] & 0x7f) | ((data[2] & 0x7f) << 7));
+		break;
+	case 0xb0:
+		if (data[1] == 123)
+			std::fill(velocities.begin() + channel * 128, velocities.begin() + (channel + 1) * 128, 0);
+		break;
+	default:
+		break;
+	}
+}
+
+uint8_t EventLogFormat::HeldNotes::getVelocity(int channel, int note) const
+{
+	return velocities[(size_t)(channel * 128 + note)];
+}
+
+std::vector<EventLogFormat::Record> EventLogFormat::HeldNotes::getSnapshot(uint64_t microseconds) const
+{
+	std::vector<Record> snapshot;
+	for (int channel = 0; channel < 16; channel++)
+	{
+		const uint16_t pitchbend = pitchbends[(size_t)channel];
+		if (pitchbend != centredPitchbend)
+		{
+			const uint8_t data[3] = { (uint8_t)(0xe0 | channel), (uint8_t)(pitchbend & 0x7f), (uint8_t)(pitchbend >> 7) };
+			snapshot.push_back(makeRecord(microseconds, data, 3, snapshotFlag));
+		}
+		for (int note = 0; note < 128; note++)
+		{
+			const uint8_t velocity = getVelocity(channel, note);
+			if (velocity == 0)
+				continue;
+			const uint8_t data[3] = { (uint8_t)(0x90 | channel), (uint8_t)note, velocity };
+			snapshot.push_back(makeRecord(microseconds, data, 3, snapshotFlag));
+		}
+	}
+	return snapshot;
+}
+
+size_t EventLogFormat::findIndexEntry(const IndexEntry* index, size_t numIndexEntries, uint64_t record)
+{
+	const IndexEntry* indexEnd = index + numIndexEntries;
+	const IndexEntry* after = std::upper_bound(index, indexEnd, record,
+		[](uint64_t recordIndex, const IndexEntry& entry) { return recordIndex < entry.record; });
+	return after == index ? numIndexEntries : (size_t)(after - 1 - index);
+}
+
+uint64_t EventLogFormat::seek(const Record* records, uint64_t numRecords,
+	const IndexEntry* index, size_t numIndexEntries, uint64_t microseconds)
+{
+	// Narrow the search down to the second the time falls in
+	uint64_t begin = 0;
+	uint64_t end = numRecords;
+	const IndexEntry* indexEnd = index + numIndexEntries;
+	const IndexEntry* after = std::upper_bound(index, indexEnd, microseconds,
+		[](uint64_t time, const IndexEntry& entry) { return time < entry.microseconds; });
+	if (after != index)
+		begin = std::min((after - 1)->record, numRecords);
+	if (after != indexEnd)
+		end = std::min(std::max(after->record + 1, begin), numRecords);
+
+	const Record* found = std::lower_bound(records + begin, records + end, microseconds,
+		[](const Record& record, uint64_t time) { return record.microseconds < time; });
+	return (uint64_t)(found - records);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// On-disk layout of a session event log: a header followed by fixed size records in time order,
+// only ever appended to. A sidecar index file holds one entry per second of log time, so seeking
+// touches a handful of pages instead of searching the whole mapped log.
+//
+// From version 2 every index entry points at a snapshot: note ons and pitch bends that restore
+// the notes held at that point, flagged so replays don't play them. Rebuilding the held notes at
+// any time then only reads from the index entry before it.
+namespace EventLogFormat
+{
+	constexpr char magic[8] = { 'M', 'V', 'E', 'V', 'L', 'O', 'G', '1' };
+	constexpr uint32_t version = 2;
+	// Version 1 logs have no snapshots, so rebuilding the held notes reads from the start
+	constexpr uint32_t firstVersionWithSnapshots = 2;
+	constexpr uint64_t indexIntervalMicroseconds = 1000000;
+	// Record flag of the messages that make up a snapshot
+	constexpr uint32_t snapshotFlag = 1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t recordSize;
+		// Wall clock time the log was started at, for display
+		int64_t startUnixMilliseconds;
+		// Records written so far. Updated by the writer after every batch.
+		uint64_t numRecords;
+		uint8_t reserved[32];
+
+		bool isValid() const;
+	};
+
+	// One MIDI message of up to three bytes. Longer messages, like SysEx, aren't logged.
+	struct Record
+	{
+		// When the message is heard, since the log was started
+		uint64_t microseconds;
+		uint8_t size;
+		uint8_t data[3];
+		uint32_t flags;
+	};
+
+	// First record at or after a whole second of log time, which from version 2 is the start of
+	// a snapshot
+	struct IndexEntry
+	{
+		uint64_t microseconds;
+		uint64_t record;
+	};
+
+	static_assert(sizeof(Header) == 64, "The header layout is part of the file format");
+	static_assert(sizeof(Record) == 16, "The record layout is part of the file format");
+	static_assert(sizeof(IndexEntry) == 16, "The index layout is part of the file format");
+
+	// Notes held and pitch bends per MIDI channel, followed through a log's messages
+	struct HeldNotes
+	{
+		static constexpr uint16_t centredPitchbend = 8192;
+
+		HeldNotes();
+		void clear();
+		// Ignores anything other than note ons, note offs, pitch bends and all notes off
+		void apply(const Record&);
+		uint8_t getVelocity(int channel, int note) const;
+		// Pitch bends and note ons that restore the held notes, as flagged snapshot records
+		std::vector<Record> getSnapshot(uint64_t microseconds) const;
+
+		// 16 channels of 128 notes, 0 where the note isn't held
+		std::array<uint8_t, 16 * 128> velocities;
+		std::array<uint16_t, 16> pitchbends;
+	};
+
+	Header makeHeader(int64_t startUnixMilliseconds);
+	// Record of a MIDI message of up to three bytes
+	Record makeRecord(uint64_t microseconds, const uint8_t* data, int size, uint32_t flags = 0);
+	// Index of the last entry at or before the record, or numIndexEntries if there's none
+	size_t findIndexEntry(const IndexEntry* index, size_t numIndexEntries, uint64_t record);
+	// Index of the first record at or after the time, or numRecords
+	uint64_t seek(const Record* records, uint64_t numRecords,
+		const IndexEntry* index, size_t numIndexEntries, uint64_t microseconds);
+}
@@ -0,0 +1,207 @@
+#include "EventLogPlayer.h"
+#include "EventLogWriter.h"
+
+namespace {
+// Longest the thread sleeps at a time, so stopping is quick
+const double maxWaitMs = 50.0;
+}
+
+EventLogPlayer::EventLogPlayer(juce::MidiMessageCollector& collector) :
+	juce::Thread("Event log player"),
+	collector(collector),
+	records(nullptr),
+	numRecords(0),
+	hasSnapshots(false),
+	startRecord(0),
+	startMicroseconds(0),
+	speed(1.0),
+	playing(false),
+	positionSeconds(0)
+{
+}
+
+EventLogPlayer::~EventLogPlayer()
+{
+	close();
+}
+
+juce::String EventLogPlayer::open(const juce::File& logFile)
+{
+	close();
+
+	mapping = std::make_unique<juce::MemoryMappedFile>(logFile, juce::MemoryMappedFile::readOnly);
+	if (mapping->getData() == nullptr || mapping->getSize() < sizeof(EventLogFormat::Header))
+	{
+		mapping.reset();
+		return "Can't open " + logFile.getFullPathName();
+	}
+
+	const auto* header = static_cast<const EventLogFormat::Header*>(mapping->getData());
+	if (!header->isValid())
+	{
+		mapping.reset();
+		return logFile.getFileName() + " isn't a MIDI Vis event log";
+	}
+
+	// A log that's still being written has a partly used chunk after its records
+	const uint64_t numMapped = (mapping->getSize() - sizeof(EventLogFormat::Header)) / sizeof(EventLogFormat::Record);
+	numRecords = std::min(header->numRecords, (uint64_t)numMapped);
+	records = reinterpret_cast<const EventLogFormat::Record*>(header + 1);
+	hasSnapshots = header->version >= EventLogFormat::firstVersionWithSnapshots;
+
+	juce::MemoryBlock indexData;
+	EventLogWriter::getIndexFile(logFile).loadFileAsData(indexData);
+	index.resize(indexData.getSize() / sizeof(EventLogFormat::IndexEntry));
+	if (!index.empty())
+		indexData.copyTo(index.data(), 0, index.size() * sizeof(EventLogFormat::IndexEntry));
+	// Entries for records past the header's count, from a writer that didn't finish
+	while (!index.empty() && index.back().record >= numRecords)
+		index.pop_back();
+
+	file = logFile;
+	return {};
+}
+
+void EventLogPlayer::close()
+{
+	stop();
+	mapping.reset();
+	records = nullptr;
+	numRecords = 0;
+	index.clear();
+	file = juce::File();
+}
+
+bool EventLogPlayer::isOpen() const
+{
+	return records != nullptr;
+}
+
+juce::File EventLogPlayer::getFile() const
+{
+	return file;
+}
+
+double EventLogPlayer::getLengthSeconds() const
+{
+	return numRecords == 0 ? 0.0 : records[numRecords - 1].microseconds * 1.0e-6;
+}
+
+void EventLogPlayer::play(double fromSeconds, double playbackSpeed)
+{
+	stop();
+	if (!isOpen())
+		return;
+
+	startMicroseconds = (uint64_t)(std::max(0.0, fromSeconds) * 1.0e6);
+	startRecord = EventLogFormat::seek(records, numRecords, index.data(), index.size(), startMicroseconds);
+	speed = std::max(0.01, playbackSpeed);
+	positionSeconds.store(startMicroseconds * 1.0e-6);
+	playing.store(true);
+	startThread();
+}
+
+void EventLogPlayer::stop()
+{
+	if (!isThreadRunning() && !playing.load())
+		return;
+
+	stopThread(1000);
+	playing.store(false);
+}
+
+bool EventLogPlayer::isPlaying() const
+{
+	return playing.load();
+}
+
+double EventLogPlayer::getPositionSeconds() const
+{
+	return positionSeconds.load();
+}
+
+void EventLogPlayer::send(const EventLogFormat::Record& record)
+{
+	if (record.size < 1 || record.size > 3)
+		return;
+	juce::MidiMessage message(record.data, record.size, juce::Time::getMillisecondCounterHiRes() * 0.001);
+	collector.addMessageToQueue(message);
+	sounding.apply(record);
+}
+
+// Walks the log from the snapshot before the start point. Logs without snapshots are walked
+// from the beginning.
+void EventLogPlayer::restoreHeldNotes(uint64_t record)
+{
+	// A start point within a snapshot, which replays skip, begins where it ends. Otherwise the
+	// index entry found could be the snapshot's own, with nothing before the start point.
+	uint64_t end = record;
+	while (end < numRecords && (records[end].flags & EventLogFormat::snapshotFlag) != 0)
+		end++;
+
+	uint64_t begin = 0;
+	if (hasSnapshots)
+	{
+		const size_t entry = EventLogFormat::findIndexEntry(index.data(), index.size(), end);
+		if (entry < index.size())
+			begin = index[entry].record;
+	}
+
+	EventLogFormat::HeldNotes held;
+	for (uint64_t i = begin; i < end; i++)
+	{
+		if (threadShouldExit())
+			return;
+		held.apply(records[i]);
+	}
+
+	for (const EventLogFormat::Record& message : held.getSnapshot(0))
+		send(message);
+}
+
+void EventLogPlayer::releaseSoundingNotes()
+{
+	for (int channel = 0; channel < 16; channel++)
+	{
+		for (int note = 0; note < 128; note++)
+		{
+			if (sounding.getVelocity(channel, note) == 0)
+				continue;
+			const uint8_t data[3] = { (uint8_t)(0x80 | channel), (uint8_t)note, 0 };
+			send(EventLogFormat::makeRecord(0, data, 3));
+		}
+	}
+}
+
+void EventLogPlayer::run()
+{
+	sounding.clear();
+	restoreHeldNotes(startRecord);
+
+	const double startMs = juce::Time::getMillisecondCounterHiRes();
+	uint64_t i = startRecord;
+	while (i < numRecords && !threadShouldExit())
+	{
+		const EventLogFormat::Record& record = records[i];
+		const double logMs = (double)(record.microseconds - std::min(record.microseconds, startMicroseconds)) * 0.001;
+		const double dueMs = startMs + logMs / speed;
+		const double nowMs = juce::Time::getMillisecondCounterHiRes();
+		if (dueMs > nowMs)
+		{
+			positionSeconds.store(startMicroseconds * 1.0e-6 + (nowMs - startMs) * speed * 0.001);
+			wait((int)std::ceil(std::min(dueMs - nowMs, maxWaitMs)));
+			continue;
+		}
+
+		// Snapshots only restate the notes already sounding
+		if ((record.flags & EventLogFormat::snapshotFlag) == 0)
+			send(record);
+		positionSeconds.store(record.microseconds * 1.0e-6);
+		i++;
+	}
+
+	// Whether it finished or was stopped, nothing the replay started keeps sounding. Notes
+	// played live meanwhile are left alone.
+	releaseSoundingNotes();
+	playing.store(false);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "EventLogFormat.h"
+
+// Plays an EventLogFormat file back into a MidiMessageCollector, which processBlock drains into
+// the MPEInstrument like live input, so the editor and history see a replay like a performance.
+//
+// The log is memory-mapped read-only and walked on a background thread that sleeps until each
+// message is due. Playback can start anywhere and run at any speed. Notes held at the start
+// point are sounded first so a replay from the middle of a chord looks right. They're rebuilt
+// from the snapshot at the index entry before the start point, so seeking costs the same
+// anywhere in a long log.
+class EventLogPlayer : private juce::Thread
+{
+public:
+	explicit EventLogPlayer(juce::MidiMessageCollector&);
+	~EventLogPlayer() override;
+
+	// Message thread. Returns a description of the problem if the file isn't a usable log.
+	juce::String open(const juce::File&);
+	void close();
+	bool isOpen() const;
+	juce::File getFile() const;
+	double getLengthSeconds() const;
+
+	// Every note the replay started is released when it ends or is stopped
+	void play(double fromSeconds, double speed);
+	void stop();
+	bool isPlaying() const;
+	// Log time reached by the replay
+	double getPositionSeconds() const;
+private:
+	void run() override;
+	// Sends pitch bends and note ons for the notes held just before the record
+	void restoreHeldNotes(uint64_t record);
+	// Sends a message of the replay, following the notes it leaves sounding
+	void send(const EventLogFormat::Record&);
+	// Note offs for whatever the replay left sounding
+	void releaseSoundingNotes();
+
+	juce::MidiMessageCollector& collector;
+
+	juce::File file;
+	std::unique_ptr<juce::MemoryMappedFile> mapping;
+	const EventLogFormat::Record* records;
+	uint64_t numRecords;
+	std::vector<EventLogFormat::IndexEntry> index;
+	bool hasSnapshots;
+
+	uint64_t startRecord;
+	uint64_t startMicroseconds;
+	double speed;
+	std::atomic<bool> playing;
+	std::atomic<double> positionSeconds;
+
+	// Player thread. Notes sent by the replay and not released yet.
+	EventLogFormat::HeldNotes sounding;
+};
@@ -0,0 +1,37 @@
+#include "EventLogQueue.h"
+
+EventLogQueue::EventLogQueue() : records(), writeIndex(0), readIndex(0), numDropped(0) {}
+
+bool EventLogQueue::push(const EventLogFormat::Record& record)
+{
+	const uint32_t write = writeIndex.load(std::memory_order_relaxed);
+	const uint32_t read = readIndex.load(std::memory_order_acquire);
+
+	if (write - read >= capacity)
+	{
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	records[write & indexMask] = record;
+	writeIndex.store(write + 1, std::memory_order_release);
+	return true;
+}
+
+bool EventLogQueue::pop(EventLogFormat::Record& record)
+{
+	const uint32_t read = readIndex.load(std::memory_order_relaxed);
+	const uint32_t write = writeIndex.load(std::memory_order_acquire);
+
+	if (read == write)
+		return false;
+
+	record = records[read & indexMask];
+	readIndex.store(read + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t EventLogQueue::getNumDropped() const
+{
+	return numDropped.load(std::memory_order_relaxed);
+}
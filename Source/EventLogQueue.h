@@ -0,0 +1,30 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "EventLogFormat.h"
+
+// Wait-free single-producer/single-consumer ring of log records, from the audio thread to the
+// log's writer thread. When the ring is full new records are dropped and counted instead of blocking.
+class EventLogQueue
+{
+public:
+	// Must be a power of two. About 8 seconds of the densest playing the writer has to fall behind by.
+	static constexpr uint32_t capacity = 8192;
+
+	EventLogQueue();
+	bool push(const EventLogFormat::Record&);
+	bool pop(EventLogFormat::Record&);
+	uint32_t getNumDropped() const;
+private:
+	static constexpr uint32_t indexMask = capacity - 1;
+
+	std::array<EventLogFormat::Record, capacity> records;
+
+	// Kept on separate cache lines so producer and consumer don't false-share
+	alignas(64) std::atomic<uint32_t> writeIndex;
+	alignas(64) std::atomic<uint32_t> readIndex;
+	alignas(64) std::atomic<uint32_t> numDropped;
+};
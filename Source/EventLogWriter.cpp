@@ -0,0 +1,229 @@
+#include "EventLogWriter.h"
+
+namespace {
+const int64_t headerBytes = sizeof(EventLogFormat::Header);
+const int64_t recordBytes = sizeof(EventLogFormat::Record);
+const int writeIntervalMs = 100;
+}
+
+EventLogWriter::EventLogWriter() :
+	juce::Thread("Event log writer"),
+	logging(false),
+	originSeconds(0),
+	chunkRecords(nullptr),
+	chunkFirstRecord(0),
+	chunkNumRecords(0),
+	nextIndexMicroseconds(0),
+	numRecords(0),
+	failed(false)
+{
+}
+
+EventLogWriter::~EventLogWriter()
+{
+	stop();
+}
+
+juce::File EventLogWriter::getIndexFile(const juce::File& logFile)
+{
+	return juce::File(logFile.getFullPathName() + ".idx");
+}
+
+juce::String EventLogWriter::start(const juce::File& logFile, double origin)
+{
+	stop();
+
+	juce::File indexFile = getIndexFile(logFile);
+	if (indexFile.exists() && !indexFile.deleteFile())
+		return "Can't replace " + indexFile.getFullPathName();
+
+	EventLogFormat::Header header = EventLogFormat::makeHeader(juce::Time::currentTimeMillis());
+	if (!logFile.replaceWithData(&header, sizeof(header)))
+		return "Can't write " + logFile.getFullPathName();
+
+	headerMapping = std::make_unique<juce::MemoryMappedFile>(logFile, juce::Range<juce::int64>(0, headerBytes),
+		juce::MemoryMappedFile::readWrite);
+	indexStream = std::make_unique<juce::FileOutputStream>(indexFile);
+	if (headerMapping->getData() == nullptr || indexStream->failedToOpen())
+	{
+		headerMapping.reset();
+		indexStream.reset();
+		return "Can't map " + logFile.getFullPathName();
+	}
+
+	file = logFile;
+	originSeconds = origin;
+	chunkMapping.reset();
+	chunkRecords = nullptr;
+	chunkNumRecords = 0;
+	nextIndexMicroseconds = 0;
+	heldNotes.clear();
+	numRecords.store(0);
+	failed = false;
+
+	// Anything pushed while the previous log was being stopped
+	EventLogFormat::Record stale;
+	while (queue.pop(stale)) {}
+
+	logging.store(true);
+	startThread();
+	return {};
+}
+
+void EventLogWriter::stop()
+{
+	if (!logging.exchange(false))
+		return;
+
+	signalThreadShouldExit();
+	notify();
+	stopThread(2000);
+	writeQueued();
+
+	// The last chunk is only partly used
+	const int64_t usedBytes = headerBytes + (int64_t)numRecords.load() * recordBytes;
+	chunkMapping.reset();
+	headerMapping.reset();
+	indexStream.reset();
+	{
+		juce::FileOutputStream stream(file);
+		if (!stream.failedToOpen())
+		{
+			stream.setPosition(usedBytes);
+			stream.truncate();
+		}
+	}
+}
+
+bool EventLogWriter::isLogging() const
+{
+	return logging.load();
+}
+
+juce::File EventLogWriter::getFile() const
+{
+	return file;
+}
+
+uint64_t EventLogWriter::getNumRecords() const
+{
+	return numRecords.load();
+}
+
+uint32_t EventLogWriter::getNumDropped() const
+{
+	return queue.getNumDropped();
+}
+
+void EventLogWriter::push(const juce::MidiMessage& message, double timeSeconds)
+{
+	// Pairs with the store in start(), after originSeconds is set
+	if (!logging.load(std::memory_order_acquire))
+		return;
+
+	const int size = message.getRawDataSize();
+	if (size < 1 || size > 3)
+		return;
+
+	const double microseconds = (timeSeconds - originSeconds) * 1.0e6;
+	queue.push(EventLogFormat::makeRecord(microseconds > 0 ? (uint64_t)microseconds : 0, message.getRawData(), size));
+}
+
+EventLogFormat::Header* EventLogWriter::getHeader() const
+{
+	return static_cast<EventLogFormat::Header*>(headerMapping->getData());
+}
+
+void EventLogWriter::run()
+{
+	while (!threadShouldExit())
+	{
+		wait(writeIntervalMs);
+		writeQueued();
+	}
+}
+
+// Grows the file by a chunk and maps it, so records can be written with plain stores
+bool EventLogWriter::mapChunkFor(uint64_t record)
+{
+	chunkMapping.reset();
+	chunkRecords = nullptr;
+
+	const uint64_t recordsPerChunk = (uint64_t)(chunkBytes / recordBytes);
+	chunkFirstRecord = record - record % recordsPerChunk;
+	const int64_t chunkStart = headerBytes + (int64_t)chunkFirstRecord * recordBytes;
+	const int64_t chunkEnd = chunkStart + chunkBytes;
+
+	if (file.getSize() < chunkEnd)
+	{
+		juce::FileOutputStream stream(file);
+		if (stream.failedToOpen() || !stream.setPosition(chunkEnd - 1) || !stream.writeByte(0))
+			return false;
+	}
+
+	chunkMapping = std::make_unique<juce::MemoryMappedFile>(file, juce::Range<juce::int64>(chunkStart, chunkEnd),
+		juce::MemoryMappedFile::readWrite);
+	if (chunkMapping->getData() == nullptr)
+	{
+		chunkMapping.reset();
+		return false;
+	}
+
+	// Mappings start on a page boundary at or before the requested range
+	const int64_t offset = chunkStart - chunkMapping->getRange().getStart();
+	chunkRecords = reinterpret_cast<EventLogFormat::Record*>(static_cast<char*>(chunkMapping->getData()) + offset);
+	chunkNumRecords = recordsPerChunk;
+	return true;
+}
+
+bool EventLogWriter::append(const EventLogFormat::Record& record, uint64_t& count)
+{
+	if (chunkRecords == nullptr || count >= chunkFirstRecord + chunkNumRecords)
+	{
+		if (!mapChunkFor(count))
+		{
+			// Out of disk space or similar. Keep what was written so far.
+			failed = true;
+			return false;
+		}
+	}
+	chunkRecords[count - chunkFirstRecord] = record;
+	count++;
+	return true;
+}
+
+bool EventLogWriter::appendSnapshot(uint64_t microseconds, uint64_t& count)
+{
+	for (const EventLogFormat::Record& record : heldNotes.getSnapshot(microseconds))
+		if (!append(record, count))
+			return false;
+	return true;
+}
+
+void EventLogWriter::writeQueued()
+{
+	if (headerMapping == nullptr || failed)
+		return;
+
+	uint64_t count = numRecords.load();
+	EventLogFormat::Record record;
+	while (queue.pop(record))
+	{
+		if (record.microseconds >= nextIndexMicroseconds)
+		{
+			EventLogFormat::IndexEntry entry{ record.microseconds, count };
+			indexStream->write(&entry, sizeof(entry));
+			nextIndexMicroseconds = (record.microseconds / EventLogFormat::indexIntervalMicroseconds + 1)
+				* EventLogFormat::indexIntervalMicroseconds;
+			if (!appendSnapshot(record.microseconds, count))
+				break;
+		}
+		if (!append(record, count))
+			break;
+		heldNotes.apply(record);
+	}
+
+	getHeader()->numRecords = count;
+	indexStream->flush();
+	numRecords.store(count);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+
+#include "EventLogFormat.h"
+#include "EventLogQueue.h"
+
+// Appends the MIDI input to a memory-mapped EventLogFormat file on a background thread.
+//
+// The audio thread only pushes 16 byte records into a wait-free queue. The writer thread drains
+// it a few times a second into the mapped file, which grows a chunk at a time, and appends to
+// the sidecar index along with a snapshot of the held notes. Nothing but the current chunk is
+// kept in memory.
+class EventLogWriter : private juce::Thread
+{
+public:
+	// Grown and mapped this much at a time. A multiple of the page size.
+	static constexpr int64_t chunkBytes = 4 * 1024 * 1024;
+
+	EventLogWriter();
+	~EventLogWriter() override;
+
+	// Message thread. Event times are logged relative to originSeconds.
+	// Returns a description of the problem if the log can't be created.
+	juce::String start(const juce::File&, double originSeconds);
+	// Writes out what's still queued and trims the file to its records
+	void stop();
+	bool isLogging() const;
+	juce::File getFile() const;
+	uint64_t getNumRecords() const;
+	uint32_t getNumDropped() const;
+
+	// Audio thread. Never blocks or allocates.
+	void push(const juce::MidiMessage&, double timeSeconds);
+
+	// Sidecar index of a log file
+	static juce::File getIndexFile(const juce::File&);
+private:
+	void run() override;
+	void writeQueued();
+	// Writes the record at count and advances it. False if the file can't grow.
+	bool append(const EventLogFormat::Record&, uint64_t& count);
+	// The held notes as flagged note ons and pitch bends, at the start of an index entry
+	bool appendSnapshot(uint64_t microseconds, uint64_t& count);
+	bool mapChunkFor(uint64_t record);
+	EventLogFormat::Header* getHeader() const;
+
+	EventLogQueue queue;
+	std::atomic<bool> logging;
+	double originSeconds;
+
+	// Writer thread, or the message thread while the writer thread is stopped
+	juce::File file;
+	std::unique_ptr<juce::MemoryMappedFile> headerMapping;
+	std::unique_ptr<juce::MemoryMappedFile> chunkMapping;
+	EventLogFormat::Record* chunkRecords;
+	uint64_t chunkFirstRecord;
+	uint64_t chunkNumRecords;
+	std::unique_ptr<juce::FileOutputStream> indexStream;
+	uint64_t nextIndexMicroseconds;
+	// As of the last record written
+	EventLogFormat::HeldNotes heldNotes;
+	std::atomic<uint64_t> numRecords;
+	bool failed;
+};
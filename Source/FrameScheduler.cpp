@@ -0,0 +1,167 @@
+#include "FrameScheduler.h"
+
+namespace {
+const int fallbackHz = 60;
+// Weight of the newest sample in the running averages
+const double smoothing = 0.1;
+
+double now()
+{
+	return juce::Time::getMillisecondCounterHiRes() * 0.001;
+}
+
+void smooth(double& average, double sample)
+{
+	average = average <= 0 ? sample : average + (sample - average) * smoothing;
+}
+}
+
+FrameScheduler::FrameScheduler(juce::Component& component, std::function<bool(double)> onFrame) :
+	component(component),
+	onFrame(std::move(onFrame)),
+	running(false),
+	maxLoad(0.5),
+	idleHz(0),
+	lastVBlankTime(0),
+	lastFrameTime(0),
+	frameBudgetSeconds(1.0 / fallbackHz),
+	averageWorkSeconds(0),
+	averageFrameIntervalSeconds(0),
+	numDroppedFrames(0)
+{
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	stopTimer();
+	cancelPendingUpdate();
+}
+
+void FrameScheduler::wake()
+{
+	if (running)
+		return;
+
+	running = true;
+	lastVBlankTime = 0;
+	lastFrameTime = 0;
+	averageFrameIntervalSeconds = 0;
+	stopTimer();
+
+#if JUCE_MAJOR_VERSION >= 7
+	cancelPendingUpdate();
+	if (vBlankAttachment == nullptr)
+		vBlankAttachment = std::make_unique<juce::VBlankAttachment>(&component, [this] { vBlank(); });
+#else
+	startTimerHz(fallbackHz);
+#endif
+}
+
+bool FrameScheduler::isRunning() const
+{
+	return running;
+}
+
+void FrameScheduler::stop()
+{
+	// Usually called from within the vblank callback, which the attachment can't be destroyed
+	// from, so it's released by the next message. Vblanks until then are ignored.
+	running = false;
+#if JUCE_MAJOR_VERSION >= 7
+	if (vBlankAttachment != nullptr)
+		triggerAsyncUpdate();
+#endif
+
+	if (idleHz > 0)
+		startTimer(juce::jmax(1, juce::roundToInt(1000.0 / idleHz)));
+	else
+		stopTimer();
+}
+
+void FrameScheduler::handleAsyncUpdate()
+{
+#if JUCE_MAJOR_VERSION >= 7
+	if (!running)
+		vBlankAttachment.reset();
+#endif
+}
+
+void FrameScheduler::timerCallback()
+{
+	if (running)
+		vBlank();
+	else if (onFrame(now()))
+		wake();
+}
+
+void FrameScheduler::vBlank()
+{
+	if (!running)
+		return;
+
+	const double time = now();
+
+	// Measure the refresh interval from consecutive vblanks, whether or not we draw on them
+	if (lastVBlankTime > 0)
+	{
+		const double interval = time - lastVBlankTime;
+		if (interval > 0 && interval < 0.1)
+			smooth(frameBudgetSeconds, interval);
+	}
+	lastVBlankTime = time;
+
+	// Under load, skip vblanks until the last frame's work fits in maxLoad of the time since it started
+	if (lastFrameTime > 0 && averageWorkSeconds > frameBudgetSeconds * maxLoad
+		&& time - lastFrameTime < averageWorkSeconds / maxLoad)
+	{
+		numDroppedFrames++;
+		return;
+	}
+
+	runFrame(time);
+}
+
+void FrameScheduler::runFrame(double timeSeconds)
+{
+	if (lastFrameTime > 0)
+		smooth(averageFrameIntervalSeconds, timeSeconds - lastFrameTime);
+	lastFrameTime = timeSeconds;
+
+	const bool needsAnotherFrame = onFrame(timeSeconds);
+	smooth(averageWorkSeconds, now() - timeSeconds);
+
+	if (!needsAnotherFrame)
+		stop();
+}
+
+void FrameScheduler::setMaxLoad(double newMaxLoad)
+{
+	maxLoad = juce::jlimit(0.05, 1.0, newMaxLoad);
+}
+
+void FrameScheduler::setIdleHz(double newIdleHz)
+{
+	idleHz = juce::jmax(0.0, newIdleHz);
+	if (!running)
+		stop();
+}
+
+double FrameScheduler::getAchievedFps() const
+{
+	return running && averageFrameIntervalSeconds > 0 ? 1.0 / averageFrameIntervalSeconds : 0.0;
+}
+
+double FrameScheduler::getFrameBudgetMs() const
+{
+	return frameBudgetSeconds * 1000.0;
+}
+
+double FrameScheduler::getAverageWorkMs() const
+{
+	return averageWorkSeconds * 1000.0;
+}
+
+uint32_t FrameScheduler::getNumDroppedFrames() const
+{
+	return numDroppedFrames;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+// Calls a frame callback in step with the display refresh of a component's window.
+//
+// Uses juce::VBlankAttachment where available and falls back to a 60 Hz timer otherwise.
+// When the callback reports there's nothing left to animate the scheduler stops (or drops to
+// idleHz if that's set) until wake() is called. When a frame's work takes more than maxLoad of
+// the frame budget, vblanks are skipped so frames get dropped instead of queueing up.
+class FrameScheduler : private juce::Timer,
+	private juce::AsyncUpdater
+{
+public:
+	// The callback gets the frame time in seconds and returns whether it needs another frame
+	FrameScheduler(juce::Component&, std::function<bool(double)> onFrame);
+	~FrameScheduler() override;
+
+	// Starts producing frames again. Message thread only.
+	void wake();
+	bool isRunning() const;
+
+	// Fraction of each frame budget the callback may use before frames get dropped
+	void setMaxLoad(double);
+	// Rate to keep ticking at while idle. 0 stops completely.
+	void setIdleHz(double);
+
+	double getAchievedFps() const;
+	double getFrameBudgetMs() const;
+	double getAverageWorkMs() const;
+	uint32_t getNumDroppedFrames() const;
+private:
+	void timerCallback() override;
+	// Releases the vblank attachment once stop() has returned from its callback
+	void handleAsyncUpdate() override;
+	void vBlank();
+	void runFrame(double timeSeconds);
+	void stop();
+
+	juce::Component& component;
+	std::function<bool(double)> onFrame;
+#if JUCE_MAJOR_VERSION >= 7
+	std::unique_ptr<juce::VBlankAttachment> vBlankAttachment;
+#endif
+	bool running;
+	double maxLoad;
+	double idleHz;
+
+	double lastVBlankTime;
+	double lastFrameTime;
+	double frameBudgetSeconds;
+	double averageWorkSeconds;
+	double averageFrameIntervalSeconds;
+	uint32_t numDroppedFrames;
+};
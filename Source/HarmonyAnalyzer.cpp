@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "HarmonyAnalyzer.h"
+#include "Pitch.h"
+#include "PitchClass.h"
+
+namespace {
+// Intervals from the root as fifths, major thirds and harmonic sevenths
+struct ChordTemplate
+{
+	const char* suffix;
+	const char* shapeName;
+	int numIntervals;
+	std::array<LatticeCoordinates, HarmonyAnalyzer::maxChordSize - 1> intervals;
+};
+
+// Tried in order, so when a tempered tuning makes two templates the same, the first one names it
+const ChordTemplate chordTemplates[] = {
+	{ "", "single cell", 0, {} },
+	{ "5", "fifth", 1, { { { 1, 0, 0 } } } },
+	{ "", "major triangle", 2, { { { 1, 0, 0 }, { 0, 1, 0 } } } },
+	{ "m", "minor triangle", 2, { { { 1, 0, 0 }, { 1, -1, 0 } } } },
+	{ "sm", "septimal minor triangle", 2, { { { 1, 0, 0 }, { -1, 0, 1 } } } },
+	{ "dim", "chain of minor thirds", 2, { { { 1, -1, 0 }, { 2, -2, 0 } } } },
+	{ "aug", "column of major thirds", 2, { { { 0, 1, 0 }, { 0, 2, 0 } } } },
+	{ "sus4", "row of fifths", 2, { { { 1, 0, 0 }, { -1, 0, 0 } } } },
+	{ "sus2", "row of fifths", 2, { { { 1, 0, 0 }, { 2, 0, 0 } } } },
+	{ "maj7", "major and minor triangle", 3, { { { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } } } },
+	{ "7", "major triangle and fifth below", 3, { { { 1, 0, 0 }, { 0, 1, 0 }, { -2, 0, 0 } } } },
+	{ "h7", "major triangle and harmonic seventh", 3, { { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } } } },
+	{ "m7", "minor and major triangle", 3, { { { 1, 0, 0 }, { 1, -1, 0 }, { 2, -1, 0 } } } },
+	{ "6", "two major triangles", 3, { { { 1, 0, 0 }, { 0, 1, 0 }, { -1, 1, 0 } } } },
+	{ "m7b5", "chain of minor thirds and major third", 3, { { { 1, -1, 0 }, { 2, -2, 0 }, { 2, -1, 0 } } } },
+	{ "dim7", "chain of minor thirds", 3, { { { 1, -1, 0 }, { 2, -2, 0 }, { 3, -3, 0 } } } },
+};
+}
+
+HarmonyAnalyzer::HarmonyAnalyzer()
+{
+	setTuning(7.0, 4.0, 10.0, 6.0, 0.001);
+}
+
+void HarmonyAnalyzer::setTuning(double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11, double tolerance)
+{
+	this->semisFactor3 = semisFactor3;
+	this->semisFactor5 = semisFactor5;
+	this->semisFactor7 = semisFactor7;
+	this->semisFactor11 = semisFactor11;
+	this->tolerance = tolerance;
+	toleranceKeys = PitchClass::toleranceToKeys(tolerance);
+
+	templateKeys.clear();
+	for (const ChordTemplate& chordTemplate : chordTemplates)
+	{
+		std::array<int32_t, maxChordSize - 1> keys{};
+		for (int i = 0; i < chordTemplate.numIntervals; i++)
+			keys[i] = getIntervalKey(chordTemplate.intervals[i]);
+		templateKeys.push_back(keys);
+	}
+
+	candidates.clear();
+	for (int factor3 = -maxFactor3; factor3 <= maxFactor3; factor3++)
+	{
+		for (int factor5 = -maxFactor5; factor5 <= maxFactor5; factor5++)
+		{
+			for (int factor7 = -maxFactor7; factor7 <= maxFactor7; factor7++)
+			{
+				const LatticeCoordinates coordinates{ factor3, factor5, factor7 };
+				candidates.push_back(Candidate{ getIntervalKey(coordinates), coordinates });
+			}
+		}
+	}
+	// Thirds and sevenths count as two and three steps, as when solving Scala mappings
+	auto complexity = [](const Candidate& candidate)
+	{
+		return std::abs(candidate.coordinates.factor3) + 2 * std::abs(candidate.coordinates.factor5)
+			+ 3 * std::abs(candidate.coordinates.factor7);
+	};
+	std::stable_sort(candidates.begin(), candidates.end(), [&](const Candidate& a, const Candidate& b)
+	{
+		return complexity(a) < complexity(b);
+	});
+}
+
+int32_t HarmonyAnalyzer::getIntervalKey(const LatticeCoordinates& coordinates) const
+{
+	return PitchClass(Pitch(semisFactor3 * coordinates.factor3 + semisFactor5 * coordinates.factor5
+		+ semisFactor7 * coordinates.factor7)).getKey();
+}
+
+HarmonyAnalysis HarmonyAnalyzer::analyze(const std::vector<int32_t>& heldPitchKeys)
+{
+	HarmonyAnalysis analysis;
+	analysis.numHeldPitches = (int)heldPitchKeys.size();
+	if (heldPitchKeys.empty())
+		return analysis;
+
+	pitchClasses.clear();
+	for (int32_t key : heldPitchKeys)
+		pitchClasses.push_back(PitchClass(Pitch::fromKey(key)).getKey());
+	const int32_t bassKey = pitchClasses.front();
+
+	// Pitch classes within the tolerance of the first of a run are the same one, also across C
+	std::sort(pitchClasses.begin(), pitchClasses.end());
+	size_t numPitchClasses = 1;
+	for (size_t i = 1; i < pitchClasses.size(); i++)
+	{
+		if (pitchClasses[i] - pitchClasses[numPitchClasses - 1] > toleranceKeys)
+			pitchClasses[numPitchClasses++] = pitchClasses[i];
+	}
+	if (numPitchClasses > 1
+		&& PitchClass::distance(pitchClasses[numPitchClasses - 1], pitchClasses[0]) <= toleranceKeys)
+		numPitchClasses--;
+	pitchClasses.resize(numPitchClasses);
+	analysis.numPitchClasses = (int)numPitchClasses;
+
+	int bass = 0;
+	for (int i = 1; i < (int)numPitchClasses; i++)
+	{
+		if (PitchClass::distance(pitchClasses[i], bassKey) < PitchClass::distance(pitchClasses[bass], bassKey))
+			bass = i;
+	}
+
+	if ((int)numPitchClasses <= maxChordSize)
+	{
+		// A chord over its root is preferred to an inversion of another one
+		for (int offset = 0; offset < (int)numPitchClasses; offset++)
+		{
+			const int root = (bass + offset) % (int)numPitchClasses;
+			const int match = matchTemplate(root);
+			if (match < 0)
+				continue;
+
+			const ChordTemplate& chordTemplate = chordTemplates[match];
+			setRoot(analysis, pitchClasses[root]);
+			analysis.chordName = analysis.rootName + chordTemplate.suffix;
+			analysis.shapeName = chordTemplate.shapeName;
+			analysis.shape.push_back(LatticeCoordinates{ 0, 0, 0 });
+			for (int i = 0; i < chordTemplate.numIntervals; i++)
+				analysis.shape.push_back(chordTemplate.intervals[i]);
+			return analysis;
+		}
+	}
+
+	setRoot(analysis, pitchClasses[bass]);
+	return analysis;
+}
+
+int HarmonyAnalyzer::matchTemplate(int root) const
+{
+	const int numIntervals = (int)pitchClasses.size() - 1;
+	for (int t = 0; t < (int)templateKeys.size(); t++)
+	{
+		if (chordTemplates[t].numIntervals != numIntervals)
+			continue;
+
+		// Every other pitch class takes the closest template interval not taken yet
+		std::array<bool, maxChordSize - 1> taken{};
+		bool matches = true;
+		for (int i = 0; i < (int)pitchClasses.size() && matches; i++)
+		{
+			if (i == root)
+				continue;
+			int32_t interval = pitchClasses[i] - pitchClasses[root];
+			if (interval < 0)
+				interval += PitchClass::keysPerOctave;
+
+			int closest = -1;
+			for (int j = 0; j < numIntervals; j++)
+			{
+				const int32_t distance = PitchClass::distance(interval, templateKeys[t][j]);
+				if (!taken[j] && distance <= toleranceKeys
+					&& (closest < 0 || distance < PitchClass::distance(interval, templateKeys[t][closest])))
+					closest = j;
+			}
+			if (closest < 0)
+				matches = false;
+			else
+				taken[closest] = true;
+		}
+		if (matches)
+			return t;
+	}
+	return -1;
+}
+
+// Names the root after its simplest lattice position, or by its size in semitones when it has none
+void HarmonyAnalyzer::setRoot(HarmonyAnalysis& analysis, int32_t rootKey) const
+{
+	analysis.rootPitchClassKey = rootKey;
+	for (const Candidate& candidate : candidates)
+	{
+		if (PitchClass::distance(candidate.key, rootKey) > toleranceKeys)
+			continue;
+
+		analysis.rootOnLattice = true;
+		analysis.root = candidate.coordinates;
+		const TileDescriptor descriptor = TileDescriptor::create(
+			candidate.coordinates.factor3, candidate.coordinates.factor5, candidate.coordinates.factor7, 0,
+			semisFactor3, semisFactor5, semisFactor7, semisFactor11, tolerance);
+		analysis.rootName = descriptor.pitchName + descriptor.accidentals + descriptor.syntonicCommas;
+		return;
+	}
+	analysis.rootName = TileDescriptor::formatSemitones(PitchClass::fromKey(rootKey));
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "DescriptorTable.h"
+
+// The chord recognised in a set of held pitches and the figure it makes on the lattice
+struct HarmonyAnalysis
+{
+	// Counts the inputs submitted for analysis, so a result can be matched to the input it's for
+	uint64_t sequence = 0;
+	int numHeldPitches = 0;
+	// Distinct pitch classes after merging those within the tolerance of each other
+	int numPitchClasses = 0;
+	// Chord symbol like "C", "Ebm" or "G7", empty if the pitch classes aren't a known chord
+	std::string chordName;
+	// Like "major triangle", empty if the pitch classes aren't a known chord
+	std::string shapeName;
+	// Pitch class of the root, or of the bass if no chord was recognised, and its note name.
+	// Unset without held pitches.
+	int32_t rootPitchClassKey = 0;
+	std::string rootName;
+	// Simplest lattice position matching the root within the tolerance, if there is one in range
+	bool rootOnLattice = false;
+	LatticeCoordinates root = { 0, 0, 0 };
+	// Cells of the chord relative to the root, the root itself first
+	std::vector<LatticeCoordinates> shape;
+};
+
+// Names the chord formed by the held pitch classes. Chords are templates of lattice intervals
+// from the root, evaluated under the current tuning, so a tempered tuning recognises them by
+// the intervals it tempers them to.
+//
+// Only up to maxChordSize pitch classes can form a named chord. Past that, the cost of an
+// analysis is merging the held pitches into pitch classes, which is linear after sorting.
+class HarmonyAnalyzer
+{
+public:
+	static constexpr int maxChordSize = 4;
+	// Search range for the root's lattice position, in steps of each interval from C
+	static constexpr int maxFactor3 = 6;
+	static constexpr int maxFactor5 = 2;
+	static constexpr int maxFactor7 = 1;
+
+	HarmonyAnalyzer();
+	// Tolerance in semitones, as in TuningParameters
+	void setTuning(double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11, double tolerance);
+	// Held pitch keys sorted lowest first. Reuses internal buffers, so one analyzer per thread.
+	HarmonyAnalysis analyze(const std::vector<int32_t>& heldPitchKeys);
+private:
+	struct Candidate
+	{
+		int32_t key;
+		LatticeCoordinates coordinates;
+	};
+
+	int32_t getIntervalKey(const LatticeCoordinates&) const;
+	// Index of the chord template rooted at pitchClasses[root] that the pitch classes form, or -1
+	int matchTemplate(int root) const;
+	void setRoot(HarmonyAnalysis&, int32_t rootKey) const;
+
+	double semisFactor3;
+	double semisFactor5;
+	double semisFactor7;
+	double semisFactor11;
+	double tolerance;
+	int32_t toleranceKeys;
+	// Pitch class keys of the chord templates' intervals under the tuning, in template order
+	std::vector<std::array<int32_t, maxChordSize - 1>> templateKeys;
+	// Lattice positions in range, simplest first
+	std::vector<Candidate> candidates;
+
+	std::vector<int32_t> pitchClasses;
+};
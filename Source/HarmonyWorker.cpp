@@ -0,0 +1,83 @@
+#include "HarmonyWorker.h"
+
+HarmonyWorker::HarmonyWorker() :
+	juce::Thread("Harmony analysis"),
+	maxLatencyMs(0),
+	nextSequence(1)
+{
+	startThread();
+}
+
+HarmonyWorker::~HarmonyWorker()
+{
+	signalThreadShouldExit();
+	notify();
+	stopThread(2000);
+}
+
+uint64_t HarmonyWorker::submit(const VoiceTable& voices, const TuningParameters& tuning)
+{
+	auto input = std::make_shared<Input>();
+	input->sequence = nextSequence++;
+	input->heldPitchKeys.reserve((size_t)voices.getNumHeldPitches());
+	for (int i = 0; i < voices.getNumHeldPitches(); i++)
+		input->heldPitchKeys.push_back(voices.getHeldPitch(i).getKey());
+	input->tuning = tuning;
+	input->submitTimeMs = juce::Time::getMillisecondCounterHiRes();
+
+	std::shared_ptr<const Input> replaced = std::move(input);
+	{
+		const juce::SpinLock::ScopedLockType lock(pointersLock);
+		pendingInput.swap(replaced);
+	}
+	notify();
+	return nextSequence - 1;
+}
+
+std::shared_ptr<const HarmonyAnalysis> HarmonyWorker::getLatest() const
+{
+	const juce::SpinLock::ScopedLockType lock(pointersLock);
+	return latest;
+}
+
+double HarmonyWorker::getMaxLatencyMs() const
+{
+	return maxLatencyMs.load();
+}
+
+void HarmonyWorker::run()
+{
+	while (!threadShouldExit())
+	{
+		// A submission arriving after the exchange leaves the thread notified, so wait() returns at once
+		std::shared_ptr<const Input> input;
+		{
+			const juce::SpinLock::ScopedLockType lock(pointersLock);
+			input.swap(pendingInput);
+		}
+		if (input == nullptr)
+		{
+			wait(-1);
+			continue;
+		}
+
+		if (!analyzerTuning.has_value() || !(*analyzerTuning == input->tuning))
+		{
+			analyzer.setTuning(input->tuning.semisFactor3, input->tuning.semisFactor5,
+				input->tuning.semisFactor7, input->tuning.semisFactor11, input->tuning.tolerance);
+			analyzerTuning = input->tuning;
+		}
+
+		auto analysis = std::make_shared<HarmonyAnalysis>(analyzer.analyze(input->heldPitchKeys));
+		analysis->sequence = input->sequence;
+		std::shared_ptr<const HarmonyAnalysis> previous = std::move(analysis);
+		{
+			const juce::SpinLock::ScopedLockType lock(pointersLock);
+			latest.swap(previous);
+		}
+
+		const double latency = juce::Time::getMillisecondCounterHiRes() - input->submitTimeMs;
+		if (latency > maxLatencyMs.load(std::memory_order_relaxed))
+			maxLatencyMs.store(latency, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "HarmonyAnalyzer.h"
+#include "VoiceTable.h"
+
+// Runs HarmonyAnalyzer on its own thread, so neither the audio nor the message thread ever
+// waits for an analysis.
+//
+// The message thread submits the held pitches whenever they change. Only the newest submission
+// is kept, so a burst of changes costs a single analysis and a result is never more than one
+// analysis behind. Results are published whole by swapping one pointer under a spin lock held
+// for nothing else, so a reader always sees a complete analysis of one submission.
+class HarmonyWorker : private juce::Thread
+{
+public:
+	HarmonyWorker();
+	~HarmonyWorker() override;
+
+	// Message thread. Replaces whatever wasn't analysed yet and returns the submission's sequence.
+	uint64_t submit(const VoiceTable&, const TuningParameters&);
+	// Any thread. The newest finished analysis, null before the first one.
+	std::shared_ptr<const HarmonyAnalysis> getLatest() const;
+	// Longest time from a submission to its result being published, in milliseconds
+	double getMaxLatencyMs() const;
+private:
+	struct Input
+	{
+		uint64_t sequence;
+		std::vector<int32_t> heldPitchKeys;
+		TuningParameters tuning;
+		double submitTimeMs;
+	};
+
+	void run() override;
+
+	// Both pointers are only copied or swapped under the lock. What they pointed to before is
+	// released after letting go of it.
+	mutable juce::SpinLock pointersLock;
+	std::shared_ptr<const Input> pendingInput;
+	std::shared_ptr<const HarmonyAnalysis> latest;
+	std::atomic<double> maxLatencyMs;
+
+	// Message thread
+	uint64_t nextSequence;
+
+	// Worker thread
+	HarmonyAnalyzer analyzer;
+	std::optional<TuningParameters> analyzerTuning;
+};
@@ -0,0 +1,238 @@
+#include <algorithm>
+
+#include "IntensityModel.h"
+
+IntensityModel::IntensityModel() :
+	numEvicted(0)
+{
+	// Never more than maxPitches, so applying events never has to grow them
+	pitchStates.reserve(maxPitches);
+	pitchInfos.reserve(maxPitches);
+	releaseTimes.reserve(maxPitches);
+	slots.fill(emptySlot);
+}
+
+double IntensityModel::Ramp::at(double timeSeconds) const
+{
+	const double change = std::max(0.0, timeSeconds - startTime) / markerFadeSeconds;
+	return rising
+		? std::min(startValue + change, 1.0)
+		: std::max(startValue - change, 0.0);
+}
+
+bool IntensityModel::Ramp::isSettled(double timeSeconds) const
+{
+	const double value = at(timeSeconds);
+	return rising ? value >= 1.0 : value <= 0.0;
+}
+
+PitchInfo IntensityModel::PitchState::at(double timeSeconds) const
+{
+	const double noteIntensity = held
+		? 1.0
+		: std::max(1.0 - std::max(0.0, timeSeconds - releaseTime) / noteFadeSeconds, 0.0);
+	return PitchInfo(noteIntensity, top.at(timeSeconds), bass.at(timeSeconds));
+}
+
+void IntensityModel::applyNoteEvent(const NoteEvent& event)
+{
+	Pitch pitch(event.midiPitch);
+
+	if (event.type == NoteEvent::Type::Released)
+	{
+		// Use the pitch the voice was last held at, other voices may still hold it
+		std::optional<Pitch> releasedPitch = voices.remove(event.midiChannel, event.noteID);
+		if (releasedPitch && !voices.isHeld(*releasedPitch))
+		{
+			release(*releasedPitch, event.timeSeconds);
+			updateMarkers(event.timeSeconds);
+		}
+		return;
+	}
+
+	// A pitch bend moves the voice, leaving its old pitch to fade unless another voice holds it
+	std::optional<Pitch> previousPitch = voices.remove(event.midiChannel, event.noteID);
+	if (previousPitch && !voices.isHeld(*previousPitch))
+		release(*previousPitch, event.timeSeconds);
+
+	if (voices.add(event.midiChannel, event.noteID, pitch))
+		hold(pitch, event.timeSeconds);
+	updateMarkers(event.timeSeconds);
+}
+
+uint32_t IntensityModel::getHomeSlot(const Pitch& pitch)
+{
+	// Fibonacci hashing, so neighbouring keys spread over the table
+	return ((uint32_t)pitch.getKey() * 2654435769u) >> 19 & slotMask;
+}
+
+int IntensityModel::find(const Pitch& pitch) const
+{
+	for (uint32_t slot = getHomeSlot(pitch); slots[slot] != emptySlot; slot = (slot + 1) & slotMask)
+	{
+		if (pitchInfos[(size_t)slots[slot]].first == pitch)
+			return slots[slot];
+	}
+	return -1;
+}
+
+void IntensityModel::addToIndex(int index)
+{
+	uint32_t slot = getHomeSlot(pitchInfos[(size_t)index].first);
+	while (slots[slot] != emptySlot)
+		slot = (slot + 1) & slotMask;
+	slots[slot] = index;
+}
+
+void IntensityModel::rebuildIndex()
+{
+	slots.fill(emptySlot);
+	for (int i = 0; i < (int)pitchInfos.size(); i++)
+		addToIndex(i);
+}
+
+void IntensityModel::evictFading()
+{
+	releaseTimes.clear();
+	for (const PitchState& state : pitchStates)
+	{
+		if (!state.held)
+			releaseTimes.push_back(state.releaseTime);
+	}
+	if (releaseTimes.empty())
+		return;
+
+	std::nth_element(releaseTimes.begin(), releaseTimes.begin() + releaseTimes.size() / 2, releaseTimes.end());
+	const double cutoff = releaseTimes[releaseTimes.size() / 2];
+
+	size_t kept = 0;
+	for (size_t i = 0; i < pitchStates.size(); i++)
+	{
+		if (!pitchStates[i].held && pitchStates[i].releaseTime <= cutoff)
+			continue;
+		pitchStates[kept] = pitchStates[i];
+		pitchInfos[kept] = pitchInfos[i];
+		kept++;
+	}
+	numEvicted += (uint32_t)(pitchStates.size() - kept);
+	pitchStates.erase(pitchStates.begin() + kept, pitchStates.end());
+	pitchInfos.erase(pitchInfos.begin() + kept, pitchInfos.end());
+	rebuildIndex();
+}
+
+void IntensityModel::hold(const Pitch& pitch, double timeSeconds)
+{
+	// A new note shows its markers at full strength straight away
+	const bool top = *voices.getHighest() == pitch;
+	const bool bass = *voices.getLowest() == pitch;
+	PitchState state;
+	state.held = true;
+	state.releaseTime = timeSeconds;
+	state.top = Ramp{ top ? 1.0 : 0.0, timeSeconds, top };
+	state.bass = Ramp{ bass ? 1.0 : 0.0, timeSeconds, bass };
+
+	const int index = find(pitch);
+	if (index >= 0)
+	{
+		pitchStates[(size_t)index] = state;
+		pitchInfos[(size_t)index].second = state.at(timeSeconds);
+		return;
+	}
+
+	if ((int)pitchStates.size() >= maxPitches)
+		evictFading();
+	pitchStates.push_back(state);
+	pitchInfos.push_back({ pitch, state.at(timeSeconds) });
+	addToIndex((int)pitchInfos.size() - 1);
+}
+
+void IntensityModel::release(const Pitch& pitch, double timeSeconds)
+{
+	const int index = find(pitch);
+	if (index >= 0)
+	{
+		pitchStates[index].held = false;
+		pitchStates[index].releaseTime = timeSeconds;
+	}
+}
+
+// Starts the top/bass marker fades of pitches that stopped or started being the highest/lowest held pitch
+void IntensityModel::updateMarkers(double timeSeconds)
+{
+	std::optional<Pitch> newTopPitch = voices.getHighest();
+	std::optional<Pitch> newBassPitch = voices.getLowest();
+
+	auto retarget = [&](const std::optional<Pitch>& pitch, Ramp PitchState::* ramp, bool rising)
+	{
+		if (!pitch) return;
+		const int index = find(*pitch);
+		if (index < 0) return;
+		Ramp& r = pitchStates[(size_t)index].*ramp;
+		if (r.rising != rising)
+			r = Ramp{ r.at(timeSeconds), timeSeconds, rising };
+	};
+
+	if (!(topPitch == newTopPitch))
+	{
+		retarget(topPitch, &PitchState::top, false);
+		retarget(newTopPitch, &PitchState::top, true);
+		topPitch = newTopPitch;
+	}
+
+	if (!(bassPitch == newBassPitch))
+	{
+		retarget(bassPitch, &PitchState::bass, false);
+		retarget(newBassPitch, &PitchState::bass, true);
+		bassPitch = newBassPitch;
+	}
+}
+
+bool IntensityModel::update(double timeSeconds)
+{
+	bool animating = false;
+
+	// Evaluates every pitch and compacts away the ones that faded out, in one pass
+	size_t kept = 0;
+	for (size_t i = 0; i < pitchStates.size(); i++)
+	{
+		const PitchState& state = pitchStates[i];
+		const PitchInfo info = state.at(timeSeconds);
+
+		if (info.noteIntensity <= 0)
+			continue;
+
+		if (!state.held || !state.top.isSettled(timeSeconds) || !state.bass.isSettled(timeSeconds))
+			animating = true;
+
+		if (kept != i)
+		{
+			pitchStates[kept] = state;
+			pitchInfos[kept].first = pitchInfos[i].first;
+		}
+		pitchInfos[kept].second = info;
+		kept++;
+	}
+	if (kept != pitchStates.size())
+	{
+		pitchStates.erase(pitchStates.begin() + kept, pitchStates.end());
+		pitchInfos.erase(pitchInfos.begin() + kept, pitchInfos.end());
+		rebuildIndex();
+	}
+
+	return animating;
+}
+
+const std::vector<std::pair<Pitch, PitchInfo>>& IntensityModel::getPitchInfos() const
+{
+	return pitchInfos;
+}
+
+const VoiceTable& IntensityModel::getVoices() const
+{
+	return voices;
+}
+
+uint32_t IntensityModel::getNumEvicted() const
+{
+	return numEvicted;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "NoteEventQueue.h"
+#include "Pitch.h"
+#include "PitchInfo.h"
+#include "VoiceTable.h"
+
+// Held notes and the fading note/top/bass intensities of every pitch that sounded recently.
+// Intensities are computed in closed form from the event timestamps, so they only depend on
+// the time they're evaluated at, not on how often that happens. Only used from one thread.
+//
+// Pitches are found through a hash index, so an event costs the same however many pitches are
+// sounding, and at most maxPitches are tracked, so neither does a frame past that.
+class IntensityModel
+{
+public:
+	// A released note fades out over this long
+	static constexpr double noteFadeSeconds = 1.0 / 0.6;
+	// Top and bass markers fade in and out over this long
+	static constexpr double markerFadeSeconds = 1.0 / 9.0;
+	// Most pitches tracked at once, held or fading: room for every voice to hold its own pitch
+	// and as many again to fade. When it's full, the older half of the fades are cut short.
+	static constexpr int maxPitches = VoiceTable::capacity * 2;
+
+	IntensityModel();
+	// Events must be applied in timestamp order
+	void applyNoteEvent(const NoteEvent&);
+	// Evaluates all intensities at the given time and forgets pitches that have faded out.
+	// Returns whether any intensity is still changing.
+	bool update(double timeSeconds);
+	// Intensities as of the last update(), in no particular order
+	const std::vector<std::pair<Pitch, PitchInfo>>& getPitchInfos() const;
+	const VoiceTable& getVoices() const;
+	// Fading pitches dropped early because maxPitches were tracked
+	uint32_t getNumEvicted() const;
+private:
+	// Linear fade towards 0 or 1 starting from a known value at a known time
+	struct Ramp
+	{
+		double startValue;
+		double startTime;
+		bool rising;
+		double at(double timeSeconds) const;
+		bool isSettled(double timeSeconds) const;
+	};
+
+	struct PitchState
+	{
+		bool held;
+		double releaseTime;
+		Ramp top;
+		Ramp bass;
+		PitchInfo at(double timeSeconds) const;
+	};
+
+	// Open addressing with linear probing, at most half full. Slots hold indices into the arrays.
+	static constexpr uint32_t numSlots = maxPitches * 2;
+	static constexpr uint32_t slotMask = numSlots - 1;
+	static constexpr int32_t emptySlot = -1;
+
+	static uint32_t getHomeSlot(const Pitch&);
+	// Index of the pitch in pitchStates and pitchInfos, or -1
+	int find(const Pitch&) const;
+	void addToIndex(int);
+	void rebuildIndex();
+	// Drops the older half of the fading pitches
+	void evictFading();
+	void hold(const Pitch&, double timeSeconds);
+	void release(const Pitch&, double timeSeconds);
+	void updateMarkers(double timeSeconds);
+
+	VoiceTable voices;
+	// Flat arrays in the same order, so a frame is one pass over contiguous memory
+	std::vector<PitchState> pitchStates;
+	std::vector<std::pair<Pitch, PitchInfo>> pitchInfos;
+	std::array<int32_t, numSlots> slots;
+	std::vector<double> releaseTimes;
+	uint32_t numEvicted;
+	std::optional<Pitch> topPitch;
+	std::optional<Pitch> bassPitch;
+};
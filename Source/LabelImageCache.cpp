@@ -0,0 +1,77 @@
+#include <cmath>
+#include <tuple>
+
+#include "LabelImageCache.h"
+#include "TileStyle.h"
+
+LabelImageCache::LabelImageCache()
+{
+}
+
+bool LabelImageCache::Key::operator<(const Key& other) const
+{
+	return std::tie(fontHeight, scale, text) < std::tie(other.fontHeight, other.scale, other.text);
+}
+
+float LabelImageCache::getScale(juce::Graphics& g)
+{
+	return g.getInternalContext().getPhysicalPixelScaleFactor();
+}
+
+const juce::Image& LabelImageCache::getImage(const std::string& text, float fontHeight, float scale)
+{
+	Key key{ text, juce::roundToInt(fontHeight * 100.f), juce::roundToInt(scale * 100.f) };
+
+	auto it = images.find(key);
+	if (it != images.end())
+		return it->second;
+
+	if (images.size() >= maxImages)
+		images.clear();
+
+	// Render at physical resolution so the blit is 1:1 on high-DPI displays
+	juce::Font font(fontHeight * scale);
+	const int width = std::max(1, (int)std::ceil(font.getStringWidthFloat(text)) + 2);
+	const int height = std::max(1, (int)std::ceil(font.getHeight()));
+
+	juce::Image image(juce::Image::SingleChannel, width, height, true);
+	{
+		juce::Graphics imageGraphics(image);
+		imageGraphics.setColour(juce::Colours::white);
+		imageGraphics.setFont(font);
+		imageGraphics.drawText(text, 0, 0, width, height, juce::Justification::centred, false);
+	}
+
+	return images.emplace(std::move(key), image).first->second;
+}
+
+void LabelImageCache::drawText(juce::Graphics& g, const std::string& text, float fontHeight,
+	juce::Rectangle<int> area, juce::Justification justification, float scale)
+{
+	if (text.empty())
+		return;
+
+	const juce::Image& image = getImage(text, fontHeight, scale);
+	const juce::Rectangle<float> imageArea = justification.appliedToRectangle(
+		juce::Rectangle<float>(image.getWidth() / scale, image.getHeight() / scale), area.toFloat());
+
+	g.drawImageTransformed(image,
+		juce::AffineTransform::scale(1.f / scale).translated(imageArea.getX(), imageArea.getY()),
+		true);
+}
+
+void LabelImageCache::prepare(const TileDescriptor& descriptor, int width, int height, float scale)
+{
+	const TileStyle::LabelLayout layout = TileStyle::getLabelLayout(width, height);
+
+	auto prepareText = [&](const std::string& text, float fontHeight)
+	{
+		if (!text.empty())
+			getImage(text, fontHeight, scale);
+	};
+
+	prepareText(descriptor.pitchName, layout.pitchNameFontHeight);
+	prepareText(descriptor.accidentals, layout.accidentalsFontHeight);
+	prepareText(descriptor.syntonicCommas, layout.accidentalsFontHeight);
+	prepareText(descriptor.semitones, layout.semitonesFontHeight);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <string>
+
+#include "TileDescriptor.h"
+
+// Tile label text pre-rendered into alpha masks, keyed by text, font height and display scale.
+// Painting a label is then an image blit in the current colour instead of text shaping.
+class LabelImageCache
+{
+public:
+	LabelImageCache();
+
+	// Draws text inside area like Graphics::drawText, using the current colour
+	void drawText(juce::Graphics&, const std::string& text, float fontHeight,
+		juce::Rectangle<int> area, juce::Justification, float scale);
+
+	// Renders all labels of a tile of the given size ahead of time
+	void prepare(const TileDescriptor&, int width, int height, float scale);
+
+	static float getScale(juce::Graphics&);
+private:
+	struct Key
+	{
+		std::string text;
+		int fontHeight; // in 1/100 px
+		int scale; // in 1/100
+		bool operator<(const Key&) const;
+	};
+
+	const juce::Image& getImage(const std::string& text, float fontHeight, float scale);
+
+	std::map<Key, juce::Image> images;
+
+	// Semitone labels change with every tuning, so old ones are dropped past this size
+	static constexpr size_t maxImages = 4096;
+};
@@ -0,0 +1,102 @@
+#include <algorithm>
+
+#include "LatticeIndex.h"
+
+LatticeIndex::LatticeIndex() : numCells(0), toleranceKeys(0), needsFullUpdate(true)
+{
+}
+
+void LatticeIndex::rebuild(const DescriptorTable& table)
+{
+	const bool sameCells = table.getNumCells() == numCells;
+	numCells = table.getNumCells();
+	toleranceKeys = PitchClass::toleranceToKeys(table.getTuning().tolerance);
+
+	entries.clear();
+	entries.reserve(numCells);
+	for (int cell = 0; cell < numCells; cell++)
+	{
+		// Culled cells are never lit
+		const TileDescriptor& descriptor = table.getDescriptor(cell);
+		if (!descriptor.isCulled())
+			entries.push_back(Entry{ descriptor.pitchClass.getKey(), cell });
+	}
+	std::sort(entries.begin(), entries.end(),
+		[](const Entry& a, const Entry& b) { return a.key < b.key; });
+
+	if (!sameCells)
+	{
+		intensities.assign(numCells, PitchInfo());
+		changedFlags.assign(numCells, false);
+		litCells.clear();
+		changedCells.clear();
+		// Each holds a cell at most once, so update() never has to grow them
+		litCells.reserve(numCells);
+		changedCells.reserve(numCells);
+	}
+	needsFullUpdate = true;
+}
+
+void LatticeIndex::update(const PitchClassIntensities& pitchClassIntensities)
+{
+	for (int cell : changedCells)
+		changedFlags[cell] = false;
+	changedCells.clear();
+
+	auto markChanged = [this](int cell)
+	{
+		if (!changedFlags[cell])
+		{
+			changedFlags[cell] = true;
+			changedCells.push_back(cell);
+		}
+	};
+
+	// After a rebuild every cell may show a different pitch class
+	if (needsFullUpdate)
+	{
+		needsFullUpdate = false;
+		std::fill(intensities.begin(), intensities.end(), PitchInfo());
+		for (int cell = 0; cell < numCells; cell++)
+			markChanged(cell);
+	}
+
+	// Cells lit last frame go dark unless lit again below
+	for (int cell : litCells)
+	{
+		intensities[cell] = PitchInfo();
+		markChanged(cell);
+	}
+	litCells.clear();
+
+	for (const PitchClassIntensities::Bucket& bucket : pitchClassIntensities.getBuckets())
+	{
+		forEachMatch(PitchClass::fromKey(bucket.key), [&](int cell)
+		{
+			markChanged(cell);
+			intensities[cell].mergeMax(bucket.intensity);
+		});
+	}
+
+	for (int cell : changedCells)
+	{
+		const PitchInfo& intensity = intensities[cell];
+		if (intensity.noteIntensity > 0 || intensity.topIntensity > 0 || intensity.bassIntensity > 0)
+			litCells.push_back(cell);
+	}
+}
+
+int LatticeIndex::getNumCells() const
+{
+	return numCells;
+}
+
+const PitchInfo& LatticeIndex::getIntensity(int cell) const
+{
+	return intensities[cell];
+}
+
+const std::vector<int>& LatticeIndex::getChangedCells() const
+{
+	return changedCells;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "PitchClass.h"
+#include "PitchClassIntensities.h"
+#include "PitchInfo.h"
+
+// Maps pitch classes to the lattice cells that show them under the current tuning, so lighting
+// a note costs O(log cells + matching cells) instead of testing every cell.
+// Rebuilt whenever the tuning or lattice offsets change.
+class LatticeIndex
+{
+public:
+	LatticeIndex();
+	void rebuild(const DescriptorTable&);
+	// Recomputes cell intensities from the pitch classes sounding this frame.
+	// Only cells lit this frame or the last are touched.
+	void update(const PitchClassIntensities&);
+	// Calls back with the index of every cell within tolerance of the pitch class
+	template <typename Callback>
+	void forEachMatch(const PitchClass&, Callback&&) const;
+
+	int getNumCells() const;
+	const PitchInfo& getIntensity(int cell) const;
+	// Cells whose intensity may have changed in the last update(). All cells after a rebuild.
+	const std::vector<int>& getChangedCells() const;
+private:
+	struct Entry
+	{
+		int32_t key;
+		int cell;
+	};
+
+	template <typename Callback>
+	void forEachInRange(int32_t fromKey, int32_t toKey, Callback&) const;
+
+	int numCells;
+	// Sorted by pitch class key
+	std::vector<Entry> entries;
+	int32_t toleranceKeys;
+
+	std::vector<PitchInfo> intensities;
+	// Cells with a non-zero intensity
+	std::vector<int> litCells;
+	std::vector<int> changedCells;
+	std::vector<bool> changedFlags;
+	bool needsFullUpdate;
+};
+
+template <typename Callback>
+void LatticeIndex::forEachInRange(int32_t fromKey, int32_t toKey, Callback& callback) const
+{
+	auto it = std::lower_bound(entries.begin(), entries.end(), fromKey,
+		[](const Entry& entry, int32_t key) { return entry.key < key; });
+	for (; it != entries.end() && it->key <= toKey; ++it)
+		callback(it->cell);
+}
+
+template <typename Callback>
+void LatticeIndex::forEachMatch(const PitchClass& pitchClass, Callback&& callback) const
+{
+	const int32_t key = pitchClass.getKey();
+	const int32_t octave = PitchClass::keysPerOctave;
+
+	if (toleranceKeys * 2 >= octave)
+	{
+		forEachInRange(0, octave - 1, callback);
+		return;
+	}
+
+	// The tolerance window can wrap around the octave
+	const int32_t fromKey = key - toleranceKeys;
+	const int32_t toKey = key + toleranceKeys;
+	forEachInRange(std::max(fromKey, 0), std::min(toKey, octave - 1), callback);
+	if (fromKey < 0)
+		forEachInRange(fromKey + octave, octave - 1, callback);
+	if (toKey >= octave)
+		forEachInRange(0, toKey - octave, callback);
+}
@@ -0,0 +1,91 @@
+#include <cmath>
+#include <cstdlib>
+
+#include "LatticeProjection.h"
+
+int getAxis(const LatticeCoordinates& coordinates, LatticeAxis axis)
+{
+	switch (axis)
+	{
+	case LatticeAxis::factor3:
+		return coordinates.factor3;
+	case LatticeAxis::factor5:
+		return coordinates.factor5;
+	case LatticeAxis::factor7:
+		return coordinates.factor7;
+	default:
+		return coordinates.factor11;
+	}
+}
+
+void setAxis(LatticeCoordinates& coordinates, LatticeAxis axis, int steps)
+{
+	switch (axis)
+	{
+	case LatticeAxis::factor3:
+		coordinates.factor3 = steps;
+		break;
+	case LatticeAxis::factor5:
+		coordinates.factor5 = steps;
+		break;
+	case LatticeAxis::factor7:
+		coordinates.factor7 = steps;
+		break;
+	default:
+		coordinates.factor11 = steps;
+		break;
+	}
+}
+
+double getAxisSemitones(const TuningParameters& tuning, LatticeAxis axis)
+{
+	switch (axis)
+	{
+	case LatticeAxis::factor3:
+		return tuning.semisFactor3;
+	case LatticeAxis::factor5:
+		return tuning.semisFactor5;
+	case LatticeAxis::factor7:
+		return tuning.semisFactor7;
+	default:
+		return tuning.semisFactor11;
+	}
+}
+
+LatticeCoordinates LatticeProjection::getCellBase(int column, int row, int layer) const
+{
+	LatticeCoordinates base{ 0, 0, 0, 0 };
+	setAxis(base, horizontal, column);
+	setAxis(base, vertical, -row);
+	setAxis(base, depth, layer);
+	return base;
+}
+
+bool LatticeProjection::isDepthOnPlane(const TuningParameters& tuning) const
+{
+	const double depthSemitones = getAxisSemitones(tuning, depth);
+	const double horizontalSemitones = getAxisSemitones(tuning, horizontal);
+	const double verticalSemitones = getAxisSemitones(tuning, vertical);
+	const int maxSteps = LatticeProjections::maxPlaneSteps;
+	for (int column = -maxSteps; column <= maxSteps; column++)
+	{
+		const int maxRows = maxSteps - std::abs(column);
+		for (int row = -maxRows; row <= maxRows; row++)
+		{
+			// Same precision as TileDescriptor::isMeantone, which parameters stored as floats meet
+			double difference = std::fmod(depthSemitones - column * horizontalSemitones - row * verticalSemitones, 12.0);
+			if (difference < 0)
+				difference += 12.0;
+			if (difference < 0.00001 || difference > 12.0 - 0.00001)
+				return true;
+		}
+	}
+	return false;
+}
+
+const LatticeProjection& LatticeProjections::get(int index)
+{
+	if (index < 0 || index >= (int)projections.size())
+		return projections[0];
+	return projections[(size_t)index];
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+
+#include "DescriptorTable.h"
+
+// The lattice's dimensions, one per prime above 2
+enum class LatticeAxis
+{
+	factor3,
+	factor5,
+	factor7,
+	factor11
+};
+
+int getAxis(const LatticeCoordinates&, LatticeAxis);
+void setAxis(LatticeCoordinates&, LatticeAxis, int steps);
+// Size of one step along the axis under the tuning, in semitones
+double getAxisSemitones(const TuningParameters&, LatticeAxis);
+
+// A 2D view of the 11-limit lattice. Two axes are laid out across the grid and a third is shown
+// one step either way in each cell's corners. The lattice is sliced through every other axis at
+// that axis' offset, so only three layers of the viewport's cells exist however many dimensions
+// the lattice has.
+struct LatticeProjection
+{
+	const char* name;
+	LatticeAxis horizontal;
+	LatticeAxis vertical;
+	LatticeAxis depth;
+
+	// Lattice position of a grid cell before the offsets. Rows count downwards, so going up the
+	// grid goes up the vertical axis. The layer is 0 for a main cell and -1 or 1 for the corners.
+	LatticeCoordinates getCellBase(int column, int row, int layer) const;
+	// Whether a step along the depth axis lands within a few cells on the plane under the tuning,
+	// as a harmonic seventh does two fifths and two major thirds up in septimal meantone. The
+	// corner cells would then only repeat pitch classes already on the plane, so they're culled.
+	bool isDepthOnPlane(const TuningParameters&) const;
+};
+
+namespace LatticeProjections
+{
+	// Farthest a depth step is looked for on the plane, in steps along either of its axes
+	constexpr int maxPlaneSteps = 4;
+
+	constexpr std::array<LatticeProjection, 6> projections = { {
+		{ "Fifths and thirds", LatticeAxis::factor5, LatticeAxis::factor3, LatticeAxis::factor7 },
+		{ "Fifths and sevenths", LatticeAxis::factor7, LatticeAxis::factor3, LatticeAxis::factor5 },
+		{ "Fifths and elevenths", LatticeAxis::factor11, LatticeAxis::factor3, LatticeAxis::factor7 },
+		{ "Thirds and sevenths", LatticeAxis::factor5, LatticeAxis::factor7, LatticeAxis::factor3 },
+		{ "Thirds and elevenths", LatticeAxis::factor5, LatticeAxis::factor11, LatticeAxis::factor3 },
+		{ "Sevenths and elevenths", LatticeAxis::factor7, LatticeAxis::factor11, LatticeAxis::factor3 },
+	} };
+
+	// The projection at the index, or the first one if it's out of range
+	const LatticeProjection& get(int index);
+}
@@ -0,0 +1,234 @@
+#include <algorithm>
+
+#include "LatticeRenderer.h"
+#include "TileStyle.h"
+
+namespace {
+const size_t minBatchSlots = 64;
+
+size_t hashColour(uint32_t argb)
+{
+	return (size_t)((argb ^ (argb >> 15)) * 0x9E3779B1u >> 8);
+}
+}
+
+LatticeRenderer::LatticeRenderer(LabelImageCache& labelImageCache) :
+	labelImageCache(labelImageCache),
+	numFillBatches(0),
+	batchSlots(minBatchSlots)
+{
+}
+
+std::vector<LatticeCell> LatticeRenderer::createCells(int tileSize, const juce::Rectangle<int>& area,
+	const LatticeProjection& projection)
+{
+	// 24 px at the default 70 px tiles, so two corners never overlap when zoomed out
+	const int smallWidth = tileSize * 24 / 70;
+	const int smallHeight = tileSize * 24 / 70;
+
+	// Top left of C's cell, and the columns and rows either side of it that reach into the area
+	const int originX = area.getX() + (area.getWidth() - tileSize) / 2;
+	const int originY = area.getY() + (area.getHeight() - tileSize) / 2;
+	int minColumn = 0;
+	while (originX + minColumn * tileSize > area.getX())
+		minColumn--;
+	int maxColumn = 0;
+	while (originX + (maxColumn + 1) * tileSize < area.getRight())
+		maxColumn++;
+	int minRow = 0;
+	while (originY + minRow * tileSize > area.getY())
+		minRow--;
+	int maxRow = 0;
+	while (originY + (maxRow + 1) * tileSize < area.getBottom())
+		maxRow++;
+
+	std::vector<LatticeCell> cells;
+	cells.reserve((size_t)((maxColumn - minColumn + 1) * (maxRow - minRow + 1) * 3));
+	for (int column = minColumn; column <= maxColumn; column++)
+	{
+		for (int row = minRow; row <= maxRow; row++)
+		{
+			int xPos = originX + column * tileSize;
+			int yPos = originY + row * tileSize;
+
+			LatticeCell cell;
+			cell.layer = 0;
+			cell.base = projection.getCellBase(column, row, cell.layer);
+			cell.bounds = juce::Rectangle<int>(xPos, yPos, tileSize, tileSize);
+			cells.push_back(cell);
+
+			cell.layer = 1;
+			cell.base = projection.getCellBase(column, row, cell.layer);
+			cell.bounds = juce::Rectangle<int>(xPos + tileSize - smallWidth, yPos, smallWidth, smallHeight);
+			cells.push_back(cell);
+
+			cell.layer = -1;
+			cell.base = projection.getCellBase(column, row, cell.layer);
+			cell.bounds = juce::Rectangle<int>(xPos + tileSize - smallWidth, yPos + tileSize - smallHeight, smallWidth, smallHeight);
+			cells.push_back(cell);
+		}
+	}
+	return cells;
+}
+
+std::vector<LatticeCell> LatticeRenderer::createCells(int tileSize)
+{
+	return createCells(tileSize, getCellsBounds(tileSize).withTrimmedLeft(10).withTrimmedTop(10),
+		LatticeProjections::projections[0]);
+}
+
+juce::Rectangle<int> LatticeRenderer::getCellsBounds(int tileSize)
+{
+	return juce::Rectangle<int>(0, 0, 10 + 9 * tileSize, 10 + 13 * tileSize);
+}
+
+void LatticeRenderer::draw(juce::Graphics& g, const std::vector<LatticeCell>& cells, juce::Colour textColour)
+{
+	// Corner cells overlap the main cells, so they go in a second layer on top
+	drawLayer(g, cells, false, textColour);
+	drawLayer(g, cells, true, textColour);
+}
+
+void LatticeRenderer::drawLayer(juce::Graphics& g, const std::vector<LatticeCell>& cells, bool cornerCells, juce::Colour textColour)
+{
+	const juce::Rectangle<int> clip = g.getClipBounds();
+
+	visibleCells.clear();
+	for (const LatticeCell& cell : cells)
+	{
+		// Culled cells and those outside the clip cost nothing past this test
+		if ((cell.layer != 0) == cornerCells && !cell.descriptor.isCulled() && cell.bounds.intersects(clip))
+			visibleCells.push_back(&cell);
+	}
+
+	if (visibleCells.empty())
+		return;
+
+	// background color
+	for (const LatticeCell* cell : visibleCells)
+		addFill(TileStyle::getBackgroundColour(cell->intensity.noteIntensity), cell->bounds);
+	fillAndClear(g);
+
+	// held notes are a brighter color
+	for (const LatticeCell* cell : visibleCells)
+	{
+		if (cell->intensity.noteIntensity > TileStyle::heldThreshold)
+			addFill(TileStyle::getHeldColour(cell->intensity.noteIntensity), cell->bounds);
+	}
+	fillAndClear(g);
+
+	// bottom and top note overlays
+	for (const LatticeCell* cell : visibleCells)
+	{
+		const juce::Rectangle<int> outer = cell->bounds.reduced(TileStyle::outerRingOffset);
+		const juce::Rectangle<int> inner = cell->bounds.reduced(TileStyle::innerRingOffset);
+		addRing(TileStyle::getBassColour(cell->intensity.bassIntensity), cell->bounds, outer);
+		addRing(TileStyle::getTopColour(cell->intensity.topIntensity), outer, inner);
+	}
+	fillAndClear(g);
+
+	// outline
+	for (const LatticeCell* cell : visibleCells)
+	{
+		const juce::Rectangle<int>& b = cell->bounds;
+		const int borderSize = TileStyle::borderSize;
+		outlineBatch.addWithoutMerging(b.withHeight(borderSize));
+		outlineBatch.addWithoutMerging(juce::Rectangle<int>(b.getX(), b.getY() + borderSize, borderSize, b.getHeight() - borderSize * 2));
+		outlineBatch.addWithoutMerging(juce::Rectangle<int>(b.getRight() - borderSize, b.getY() + borderSize, borderSize, b.getHeight() - borderSize * 2));
+		outlineBatch.addWithoutMerging(b.withTop(b.getBottom() - borderSize));
+	}
+	g.setColour(TileStyle::getOutlineColour());
+	g.fillRectList(outlineBatch);
+	outlineBatch.clear();
+
+	// Only the main cells have labels
+	if (cornerCells)
+		return;
+
+	const float scale = LabelImageCache::getScale(g);
+	g.setColour(textColour);
+	for (const LatticeCell* cell : visibleCells)
+	{
+		const TileStyle::LabelLayout layout = TileStyle::getLabelLayout(cell->bounds.getWidth(), cell->bounds.getHeight());
+		const juce::Point<int> origin = cell->bounds.getPosition();
+		const TileDescriptor& descriptor = cell->descriptor;
+
+		labelImageCache.drawText(g, descriptor.pitchName, layout.pitchNameFontHeight,
+			layout.pitchName + origin, juce::Justification::centredRight, scale);
+		labelImageCache.drawText(g, descriptor.accidentals, layout.accidentalsFontHeight,
+			layout.accidentals + origin, juce::Justification::bottomLeft, scale);
+		labelImageCache.drawText(g, descriptor.syntonicCommas, layout.accidentalsFontHeight,
+			layout.syntonicCommas + origin, juce::Justification::topLeft, scale);
+		labelImageCache.drawText(g, descriptor.semitones, layout.semitonesFontHeight,
+			layout.semitones + origin, juce::Justification::bottomLeft, scale);
+	}
+}
+
+void LatticeRenderer::addFill(juce::Colour colour, const juce::Rectangle<int>& rectangle)
+{
+	if (colour.getAlpha() == 0 || rectangle.isEmpty())
+		return;
+
+	if ((numFillBatches + 1) * 2 > batchSlots.size())
+		growBatchSlots();
+
+	// Fading cells each have a colour of their own, so this is a lookup rather than a search
+	const uint32_t argb = colour.getARGB();
+	const size_t mask = batchSlots.size() - 1;
+	for (size_t slot = hashColour(argb) & mask;; slot = (slot + 1) & mask)
+	{
+		if (batchSlots[slot].first == argb)
+		{
+			fillBatches[batchSlots[slot].second].rectangles.addWithoutMerging(rectangle);
+			return;
+		}
+		if (batchSlots[slot].first == 0)
+		{
+			if (numFillBatches == fillBatches.size())
+				fillBatches.emplace_back();
+			FillBatch& batch = fillBatches[numFillBatches];
+			batch.colour = colour;
+			batch.rectangles.addWithoutMerging(rectangle);
+			batchSlots[slot] = { argb, (uint32_t)numFillBatches++ };
+			return;
+		}
+	}
+}
+
+void LatticeRenderer::growBatchSlots()
+{
+	std::vector<std::pair<uint32_t, uint32_t>> slots(batchSlots.size() * 2);
+	const size_t mask = slots.size() - 1;
+	for (size_t i = 0; i < numFillBatches; i++)
+	{
+		const uint32_t argb = fillBatches[i].colour.getARGB();
+		size_t slot = hashColour(argb) & mask;
+		while (slots[slot].first != 0)
+			slot = (slot + 1) & mask;
+		slots[slot] = { argb, (uint32_t)i };
+	}
+	batchSlots.swap(slots);
+}
+
+void LatticeRenderer::addRing(juce::Colour colour, const juce::Rectangle<int>& outer, const juce::Rectangle<int>& inner)
+{
+	// Same area as the even-odd path PitchClassTile fills, as four strips
+	addFill(colour, outer.withBottom(inner.getY()));
+	addFill(colour, outer.withTop(inner.getBottom()));
+	addFill(colour, juce::Rectangle<int>(outer.getX(), inner.getY(), inner.getX() - outer.getX(), inner.getHeight()));
+	addFill(colour, juce::Rectangle<int>(inner.getRight(), inner.getY(), outer.getRight() - inner.getRight(), inner.getHeight()));
+}
+
+void LatticeRenderer::fillAndClear(juce::Graphics& g)
+{
+	for (size_t i = 0; i < numFillBatches; i++)
+	{
+		FillBatch& batch = fillBatches[i];
+		g.setColour(batch.colour);
+		g.fillRectList(batch.rectangles);
+		// Keeps the list's storage
+		batch.rectangles.clear();
+	}
+	numFillBatches = 0;
+	std::fill(batchSlots.begin(), batchSlots.end(), std::pair<uint32_t, uint32_t>(0, 0));
+}
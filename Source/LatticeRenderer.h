@@ -0,0 +1,65 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+#include "LabelImageCache.h"
+#include "LatticeProjection.h"
+#include "PitchInfo.h"
+#include "TileDescriptor.h"
+
+// One cell of the lattice as drawn by LatticeRenderer
+struct LatticeCell
+{
+	juce::Rectangle<int> bounds;
+	// Lattice position before the offsets
+	LatticeCoordinates base;
+	// 0 for a main cell, -1 or 1 for a corner cell along the projection's depth axis
+	int layer;
+	TileDescriptor descriptor;
+	PitchInfo intensity;
+};
+
+// Draws a whole lattice in one pass, with the same visuals as PitchClassTile.
+// Fills are grouped by colour into rectangle lists so each style costs one fill call
+// per layer, and labels are blitted from a LabelImageCache.
+class LatticeRenderer
+{
+public:
+	LatticeRenderer(LabelImageCache&);
+	void draw(juce::Graphics&, const std::vector<LatticeCell>&, juce::Colour textColour);
+
+	// The grid of cells on the projection's plane overlapping the area, each with two small
+	// cells one step either way along its depth axis in its right corners. C is the cell in the
+	// middle of the area, so the grid grows and shrinks around it as the tile size changes.
+	// Cells have their lattice position but no descriptor yet.
+	static std::vector<LatticeCell> createCells(int tileSize, const juce::Rectangle<int>& area,
+		const LatticeProjection&);
+	// The original fixed 9 x 13 grid of fifths and thirds, inside getCellsBounds()
+	static std::vector<LatticeCell> createCells(int tileSize);
+	static juce::Rectangle<int> getCellsBounds(int tileSize);
+private:
+	void drawLayer(juce::Graphics&, const std::vector<LatticeCell>&, bool cornerCells, juce::Colour textColour);
+	void addFill(juce::Colour, const juce::Rectangle<int>&);
+	void addRing(juce::Colour, const juce::Rectangle<int>& outer, const juce::Rectangle<int>& inner);
+	void fillAndClear(juce::Graphics&);
+	void growBatchSlots();
+
+	struct FillBatch
+	{
+		juce::Colour colour;
+		juce::RectangleList<int> rectangles;
+	};
+
+	LabelImageCache& labelImageCache;
+
+	// Members rather than locals so their capacity is reused between draws. Only the first
+	// numFillBatches are in use; the rest are kept empty for the next colours.
+	std::vector<FillBatch> fillBatches;
+	size_t numFillBatches;
+	// Open addressing from a colour's ARGB to its batch, at most half full. Transparent colours
+	// are never batched, so ARGB 0 marks an empty slot.
+	std::vector<std::pair<uint32_t, uint32_t>> batchSlots;
+	juce::RectangleList<int> outlineBatch;
+	std::vector<const LatticeCell*> visibleCells;
+};
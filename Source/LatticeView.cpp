@@ -0,0 +1,86 @@
+#include "LatticeView.h"
+
+LatticeView::LatticeView(LabelImageCache& labelImageCache) :
+	labelImageCache(labelImageCache),
+	labelScale(1.f),
+	renderer(labelImageCache)
+{
+	setOpaque(false);
+}
+
+void LatticeView::addCell(juce::Rectangle<int> bounds, const LatticeCoordinates& base, int layer)
+{
+	LatticeCell cell;
+	cell.bounds = bounds;
+	cell.base = base;
+	cell.layer = layer;
+	cells.push_back(cell);
+	visualStates.push_back(TileStyle::VisualState{ 0, 0, 0 });
+	dirtyCells.push_back(true);
+}
+
+void LatticeView::clearCells()
+{
+	cells.clear();
+	visualStates.clear();
+	dirtyCells.clear();
+	repaint();
+}
+
+void LatticeView::setDescriptors(const DescriptorTable& table)
+{
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		LatticeCell& cell = cells[i];
+		const TileDescriptor& descriptor = table.getDescriptor((int)i);
+
+		bool labelChanged = !descriptor.hasSameLabel(cell.descriptor);
+		cell.descriptor = descriptor;
+
+		if (labelChanged)
+		{
+			dirtyCells[i] = true;
+			prepareLabels(cell);
+		}
+	}
+}
+
+void LatticeView::prepareLabels(const LatticeCell& cell)
+{
+	if (cell.layer == 0)
+		labelImageCache.prepare(cell.descriptor, cell.bounds.getWidth(), cell.bounds.getHeight(), labelScale);
+}
+
+void LatticeView::setIntensity(int i, const PitchInfo& intensity)
+{
+	cells[i].intensity = intensity;
+
+	TileStyle::VisualState visualState = TileStyle::getVisualState(intensity);
+	if (!(visualState == visualStates[i]))
+	{
+		visualStates[i] = visualState;
+		dirtyCells[i] = true;
+	}
+}
+
+int LatticeView::timerUpdate()
+{
+	int numRepainted = 0;
+	for (size_t i = 0; i < cells.size(); i++)
+	{
+		if (dirtyCells[i])
+		{
+			// JUCE coalesces these into a single paint call
+			dirtyCells[i] = false;
+			repaint(cells[i].bounds);
+			numRepainted++;
+		}
+	}
+	return numRepainted;
+}
+
+void LatticeView::paint(juce::Graphics& g)
+{
+	labelScale = LabelImageCache::getScale(g);
+	renderer.draw(g, cells, getLookAndFeel().findColour(juce::TextEditor::textColourId));
+}
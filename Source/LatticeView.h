@@ -0,0 +1,34 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "LatticeRenderer.h"
+#include "TileStyle.h"
+
+// The whole lattice as a single component, drawn in one pass by LatticeRenderer.
+// Alternative to one PitchClassTile component per cell.
+class LatticeView : public juce::Component
+{
+public:
+	LatticeView(LabelImageCache&);
+	void addCell(juce::Rectangle<int> bounds, const LatticeCoordinates& base, int layer);
+	// Removes every cell, before adding the cells for a new tile size
+	void clearCells();
+	void setDescriptors(const DescriptorTable&);
+	void setIntensity(int cell, const PitchInfo&);
+	// Repaints the cells whose visual state changed. Returns how many did.
+	int timerUpdate();
+	void paint(juce::Graphics&) override;
+private:
+	void prepareLabels(const LatticeCell&);
+
+	LabelImageCache& labelImageCache;
+	// Display scale of the last paint, used to render labels ahead of time
+	float labelScale;
+	std::vector<LatticeCell> cells;
+	std::vector<TileStyle::VisualState> visualStates;
+	std::vector<bool> dirtyCells;
+	LatticeRenderer renderer;
+};
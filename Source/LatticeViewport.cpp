@@ -0,0 +1,92 @@
+#include <cmath>
+
+#include "LatticeViewport.h"
+
+LatticeViewport::LatticeViewport() :
+	tileSize(70),
+	exactTileSize(70),
+	draggedColumns(0),
+	draggedRows(0),
+	paintStartMs(0),
+	paintMs(0)
+{
+	setMouseCursor(juce::MouseCursor::DraggingHandCursor);
+}
+
+int LatticeViewport::getTileSize() const
+{
+	return tileSize;
+}
+
+void LatticeViewport::setTileSize(int newTileSize)
+{
+	tileSize = juce::jlimit(minTileSize, maxTileSize, newTileSize);
+	exactTileSize = tileSize;
+}
+
+double LatticeViewport::takePaintMs()
+{
+	const double ms = paintMs;
+	paintMs = 0;
+	return ms;
+}
+
+void LatticeViewport::paint(juce::Graphics&)
+{
+	paintStartMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+void LatticeViewport::paintOverChildren(juce::Graphics&)
+{
+	paintMs += juce::Time::getMillisecondCounterHiRes() - paintStartMs;
+}
+
+void LatticeViewport::mouseDown(const juce::MouseEvent&)
+{
+	draggedColumns = 0;
+	draggedRows = 0;
+}
+
+// The lattice follows the pointer: dragging right brings the cells on the left into view, so
+// the horizontal offset goes down, and dragging down brings in cells above, one step up each
+void LatticeViewport::mouseDrag(const juce::MouseEvent& event)
+{
+	const juce::Point<int> offset = event.getOffsetFromDragStart();
+	const int columns = juce::roundToInt((double)offset.x / tileSize);
+	const int rows = juce::roundToInt((double)offset.y / tileSize);
+	if (columns == draggedColumns && rows == draggedRows)
+		return;
+
+	const int horizontalDelta = draggedColumns - columns;
+	const int verticalDelta = rows - draggedRows;
+	draggedColumns = columns;
+	draggedRows = rows;
+	if (onPan)
+		onPan(horizontalDelta, verticalDelta);
+}
+
+void LatticeViewport::mouseDoubleClick(const juce::MouseEvent&)
+{
+	if (onRecentre)
+		onRecentre();
+}
+
+void LatticeViewport::mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails& wheel)
+{
+	// A full wheel unit doubles or halves the tile size
+	zoomBy(std::pow(2.0, (double)wheel.deltaY));
+}
+
+void LatticeViewport::mouseMagnify(const juce::MouseEvent&, float scaleFactor)
+{
+	zoomBy((double)scaleFactor);
+}
+
+void LatticeViewport::zoomBy(double factor)
+{
+	exactTileSize = juce::jlimit((double)minTileSize, (double)maxTileSize, exactTileSize * factor);
+	const int previous = tileSize;
+	tileSize = juce::roundToInt(exactTileSize);
+	if (tileSize != previous && onZoom)
+		onZoom(tileSize);
+}
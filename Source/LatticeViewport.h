@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+
+// Window onto the lattice. Clips the cells, which the editor creates as its children for the
+// current tile size and only where they overlap it, and turns mouse gestures into pans and
+// zooms. Dragging pans by whole cells, the wheel or a pinch zooms around the middle cell, and
+// double clicking goes back to C in the middle.
+class LatticeViewport : public juce::Component
+{
+public:
+	static constexpr int minTileSize = 40;
+	static constexpr int maxTileSize = 140;
+
+	LatticeViewport();
+	int getTileSize() const;
+	// Clamped to the zoom range. Doesn't call onZoom.
+	void setTileSize(int);
+	// Time spent painting the cells since the last call, in milliseconds. Message thread only.
+	double takePaintMs();
+	void paint(juce::Graphics&) override;
+	void paintOverChildren(juce::Graphics&) override;
+	void mouseDown(const juce::MouseEvent&) override;
+	void mouseDrag(const juce::MouseEvent&) override;
+	void mouseDoubleClick(const juce::MouseEvent&) override;
+	void mouseWheelMove(const juce::MouseEvent&, const juce::MouseWheelDetails&) override;
+	void mouseMagnify(const juce::MouseEvent&, float scaleFactor) override;
+
+	// Called on the message thread with how far the offsets of the projection's horizontal and
+	// vertical axes should move, in cells
+	std::function<void(int horizontalDelta, int verticalDelta)> onPan;
+	// Called on the message thread to put the lattice offsets back to zero
+	std::function<void()> onRecentre;
+	// Called on the message thread with the new tile size after a zoom
+	std::function<void(int)> onZoom;
+private:
+	void zoomBy(double factor);
+
+	int tileSize;
+	// Unrounded, so small steps from a trackpad add up
+	double exactTileSize;
+	// Whole cells the current drag has panned so far
+	int draggedColumns;
+	int draggedRows;
+	// Every paint of the cells goes through here, so they're timed from paint() to paintOverChildren()
+	double paintStartMs;
+	double paintMs;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "NoteEventQueue.h"
+#include "BlockClock.h"
+#include "Pitch.h"
+
+// Clock shared by note event timestamps and the editor's frame times
+inline double getTimeSeconds()
+{
+	return juce::Time::getMillisecondCounterHiRes() * 0.001;
+}
+
+// Converts a note reported by juce::MPEInstrument into the compact event the IntensityModel consumes,
+// stamped with when the MIDI message that caused it is heard.
+// Must not block or allocate, it's called on the audio thread.
+inline NoteEvent makeNoteEvent(NoteEvent::Type type, const juce::MPENote& mpeNote, const EventTiming& timing)
+{
+	NoteEvent event;
+	event.type = type;
+	event.midiChannel = (uint8_t)mpeNote.midiChannel;
+	event.noteID = mpeNote.noteID;
+	event.samplePosition = timing.samplePosition;
+	event.midiPitch = Pitch::fromFreqHz(mpeNote.getFrequencyInHertz()).getMidiPitch();
+	event.blockTimeSeconds = timing.blockTimeSeconds;
+	event.timeSeconds = timing.timeSeconds;
+	return event;
+}
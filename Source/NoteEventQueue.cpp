@@ -0,0 +1,43 @@
+#include "NoteEventQueue.h"
+
+NoteEventQueue::NoteEventQueue() : events(), writeIndex(0), readIndex(0), numDropped(0) {}
+
+bool NoteEventQueue::push(const NoteEvent& event)
+{
+	const uint32_t write = writeIndex.load(std::memory_order_relaxed);
+	const uint32_t read = readIndex.load(std::memory_order_acquire);
+
+	// Indices are free-running, so the difference is the fill level even after wrapping
+	if (write - read >= capacity)
+	{
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	events[write & indexMask] = event;
+	writeIndex.store(write + 1, std::memory_order_release);
+	return true;
+}
+
+bool NoteEventQueue::pop(NoteEvent& event)
+{
+	const uint32_t read = readIndex.load(std::memory_order_relaxed);
+	const uint32_t write = writeIndex.load(std::memory_order_acquire);
+
+	if (read == write)
+		return false;
+
+	event = events[read & indexMask];
+	readIndex.store(read + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t NoteEventQueue::getNumReady() const
+{
+	return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+}
+
+uint32_t NoteEventQueue::getNumDropped() const
+{
+	return numDropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Compact note event passed from the audio thread to the message thread
+struct NoteEvent
+{
+	enum class Type : uint8_t
+	{
+		Added,
+		PitchbendChanged,
+		Released
+	};
+
+	Type type;
+	uint8_t midiChannel;
+	uint16_t noteID;
+	// Offset of the MIDI event within its audio block
+	int32_t samplePosition;
+	double midiPitch;
+	// When the event's audio block starts being heard
+	double blockTimeSeconds;
+	// When the event is heard, on the same clock the intensities are evaluated with
+	double timeSeconds;
+};
+
+// Wait-free single-producer/single-consumer ring of NoteEvents.
+// The audio thread only ever calls push(), the message thread only ever calls pop().
+// When the ring is full new events are dropped and counted instead of blocking.
+class NoteEventQueue
+{
+public:
+	// Must be a power of two
+	static constexpr uint32_t capacity = 4096;
+
+	NoteEventQueue();
+	bool push(const NoteEvent&);
+	bool pop(NoteEvent&);
+	uint32_t getNumReady() const;
+	uint32_t getNumDropped() const;
+private:
+	static constexpr uint32_t indexMask = capacity - 1;
+
+	std::array<NoteEvent, capacity> events;
+
+	// Kept on separate cache lines so producer and consumer don't false-share
+	alignas(64) std::atomic<uint32_t> writeIndex;
+	alignas(64) std::atomic<uint32_t> readIndex;
+	alignas(64) std::atomic<uint32_t> numDropped;
+};
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "PerformanceCounters.h"
+
+LogHistogram::LogHistogram() : count(0), max(0.0)
+{
+	for (std::atomic<uint32_t>& bucket : buckets)
+		bucket.store(0, std::memory_order_relaxed);
+}
+
+int LogHistogram::getBucket(double value)
+{
+	if (!(value >= 1.0))
+		return 0;
+	const int bucket = 1 + (int)(std::log2(value) * bucketsPerDoubling);
+	return std::min(bucket, numBuckets - 1);
+}
+
+double LogHistogram::getUpperEdge(int bucket)
+{
+	return std::exp2((double)bucket / bucketsPerDoubling);
+}
+
+void LogHistogram::record(double value)
+{
+	// Single writer, so plain load and store instead of read-modify-write operations
+	std::atomic<uint32_t>& bucket = buckets[getBucket(value)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	if (value > max.load(std::memory_order_relaxed))
+		max.store(value, std::memory_order_relaxed);
+}
+
+uint64_t LogHistogram::getCount() const
+{
+	return count.load(std::memory_order_relaxed);
+}
+
+double LogHistogram::getPercentile(double fraction) const
+{
+	const uint64_t total = getCount();
+	if (total == 0)
+		return 0.0;
+
+	const uint64_t target = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * (double)total));
+	uint64_t seen = 0;
+	for (int i = 0; i < numBuckets; i++)
+	{
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= target)
+			return std::min(getUpperEdge(i), getMax());
+	}
+	return getMax();
+}
+
+double LogHistogram::getMax() const
+{
+	return max.load(std::memory_order_relaxed);
+}
+
+void LogHistogram::reset()
+{
+	for (std::atomic<uint32_t>& bucket : buckets)
+		bucket.store(0, std::memory_order_relaxed);
+	count.store(0, std::memory_order_relaxed);
+	max.store(0.0, std::memory_order_relaxed);
+}
+
+std::string LogHistogram::toJson() const
+{
+	char text[160];
+	std::snprintf(text, sizeof(text), "{ \"count\": %llu, \"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f }",
+		(unsigned long long)getCount(), getPercentile(0.5), getPercentile(0.99), getMax());
+	return text;
+}
+
+PerformanceCounters::PerformanceCounters() : numMidiMessages(0), eventsPerSecond(0.0), numDroppedEvents(0)
+{
+}
+
+void PerformanceCounters::reset()
+{
+	numMidiMessages.store(0, std::memory_order_relaxed);
+	midiHandling.reset();
+	queueDepth.reset();
+	updateTiles.reset();
+	paint.reset();
+	repaintedTiles.reset();
+}
+
+std::string PerformanceCounters::toJson(const LogHistogram& lockWait) const
+{
+	char numbers[160];
+	std::snprintf(numbers, sizeof(numbers),
+		"  \"midiMessages\": %llu,\n  \"eventsPerSecond\": %.1f,\n  \"droppedEvents\": %u,\n",
+		(unsigned long long)numMidiMessages.load(std::memory_order_relaxed),
+		eventsPerSecond.load(std::memory_order_relaxed), numDroppedEvents.load(std::memory_order_relaxed));
+
+	return std::string("{\n") + numbers
+		+ "  \"queueDepth\": " + queueDepth.toJson() + ",\n"
+		+ "  \"midiHandlingMicroseconds\": " + midiHandling.toJson() + ",\n"
+		+ "  \"updateTilesMicroseconds\": " + updateTiles.toJson() + ",\n"
+		+ "  \"paintMicroseconds\": " + paint.toJson() + ",\n"
+		+ "  \"repaintedTiles\": " + repaintedTiles.toJson() + ",\n"
+		+ "  \"lockWaitMicroseconds\": " + lockWait.toJson() + "\n}\n";
+}
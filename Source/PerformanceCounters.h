@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Distribution of non-negative values in fixed logarithmic buckets, eight per doubling, so
+// percentiles read at most 9% above the recorded values. Recording is a few relaxed atomic
+// operations and never allocates, so it can stay on in the audio thread.
+//
+// Only one thread may record into a histogram. Any thread can read it meanwhile, and may see
+// a sample or two less than recorded so far.
+class LogHistogram
+{
+public:
+	static constexpr int bucketsPerDoubling = 8;
+	// Values from 2^24 up land in the last bucket, though getMax() is still exact
+	static constexpr int numBuckets = 1 + 24 * bucketsPerDoubling;
+
+	LogHistogram();
+	void record(double value);
+	uint64_t getCount() const;
+	// Upper edge of the bucket holding the given fraction of the samples, at most getMax().
+	// 0 without samples.
+	double getPercentile(double fraction) const;
+	double getMax() const;
+	// Racy against record(), which only risks keeping or losing the sample being recorded
+	void reset();
+	// As { "count": n, "p50": x, "p99": x, "max": x }
+	std::string toJson() const;
+private:
+	static int getBucket(double value);
+	static double getUpperEdge(int bucket);
+
+	// Bucket 0 holds values below 1
+	std::array<std::atomic<uint32_t>, numBuckets> buckets;
+	std::atomic<uint64_t> count;
+	std::atomic<double> max;
+};
+
+// Counters that tell which part of a frame a stutter comes from. Cheap enough to collect all
+// the time, so the overlay and the exported counters only read them. Durations are in
+// microseconds. Each histogram is written by one thread, as noted.
+struct PerformanceCounters
+{
+	PerformanceCounters();
+	void reset();
+	// Lock waits are process-wide rather than per instance, so they come from elsewhere
+	std::string toJson(const LogHistogram& lockWait) const;
+
+	// Audio thread: MIDI messages handled, and the time per block spent on them, which
+	// includes the MPEInstrument and its listeners
+	std::atomic<uint64_t> numMidiMessages;
+	LogHistogram midiHandling;
+
+	// Message thread, once per frame
+	LogHistogram queueDepth;
+	LogHistogram updateTiles;
+	// Only frames after which the lattice was painted
+	LogHistogram paint;
+	LogHistogram repaintedTiles;
+
+	// Message thread, refreshed about twice a second while frames are running
+	std::atomic<double> eventsPerSecond;
+	std::atomic<uint32_t> numDroppedEvents;
+};
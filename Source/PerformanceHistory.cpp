@@ -0,0 +1,360 @@
+#include <cmath>
+
+#include "PerformanceHistory.h"
+
+namespace {
+const uint64_t microsecondBits = 40;
+const uint64_t microsecondMask = (uint64_t(1) << microsecondBits) - 1;
+const uint64_t kindShift = 40;
+const uint64_t channelShift = 43;
+const uint64_t noteIDShift = 48;
+const uint64_t snapshotIntervalMicroseconds = (uint64_t)(PerformanceHistory::snapshotIntervalSeconds * 1.0e6);
+}
+
+PerformanceHistory::Kind PerformanceHistory::Record::getKind() const
+{
+	return (Kind)((header >> kindShift) & 0x7);
+}
+
+uint8_t PerformanceHistory::Record::getMidiChannel() const
+{
+	return (uint8_t)((header >> channelShift) & 0x1f);
+}
+
+uint16_t PerformanceHistory::Record::getNoteID() const
+{
+	return (uint16_t)(header >> noteIDShift);
+}
+
+uint64_t PerformanceHistory::Record::getMicroseconds() const
+{
+	return header & microsecondMask;
+}
+
+int32_t PerformanceHistory::Record::getPitchKey() const
+{
+	return (int32_t)(uint32_t)pitch;
+}
+
+PerformanceHistory::PerformanceHistory(double originSeconds) :
+	originSeconds(originSeconds),
+	numChunksAllocated(1),
+	lastSnapshotMicroseconds(0),
+	changedSinceSnapshot(false),
+	snapshotMissing(false),
+	snapshotIndices(new std::atomic<uint64_t>[numSnapshotSlots]),
+	numSnapshots(0),
+	claimedIndex(0),
+	endIndex(0)
+{
+	static_assert(capacity % chunkRecords == 0, "The ring must be a whole number of chunks");
+	chunks[0].reset(new std::atomic<uint64_t>[chunkRecords * 2]);
+}
+
+void PerformanceHistory::grow()
+{
+	const uint64_t allocated = numChunksAllocated.load(std::memory_order_relaxed);
+	const uint64_t writing = endIndex.load(std::memory_order_relaxed) / chunkRecords;
+	if (allocated == numChunks || writing + 1 < allocated)
+		return;
+
+	chunks[allocated].reset(new std::atomic<uint64_t>[chunkRecords * 2]);
+	numChunksAllocated.store(allocated + 1, std::memory_order_release);
+}
+
+bool PerformanceHistory::hasRoom(uint64_t end) const
+{
+	const uint64_t allocated = numChunksAllocated.load(std::memory_order_acquire);
+	// Until the ring is fully grown it hasn't wrapped either
+	return allocated == numChunks || end <= allocated * chunkRecords;
+}
+
+std::atomic<uint64_t>* PerformanceHistory::getWords(uint64_t index) const
+{
+	const uint64_t slot = index & indexMask;
+	return &chunks[slot / chunkRecords][(slot % chunkRecords) * 2];
+}
+
+uint64_t PerformanceHistory::toMicroseconds(double timeSeconds) const
+{
+	const double microseconds = std::round((timeSeconds - originSeconds) * 1.0e6);
+	if (microseconds <= 0)
+		return 0;
+	return std::min((uint64_t)microseconds, microsecondMask);
+}
+
+double PerformanceHistory::toSeconds(uint64_t microseconds) const
+{
+	return originSeconds + (double)microseconds * 1.0e-6;
+}
+
+NoteEvent::Type PerformanceHistory::toNoteEventType(Kind kind)
+{
+	switch (kind)
+	{
+	case Kind::Released:
+		return NoteEvent::Type::Released;
+	case Kind::PitchbendChanged:
+		return NoteEvent::Type::PitchbendChanged;
+	default:
+		return NoteEvent::Type::Added;
+	}
+}
+
+NoteEvent PerformanceHistory::toNoteEvent(const Record& record) const
+{
+	NoteEvent event;
+	event.type = toNoteEventType(record.getKind());
+	event.midiChannel = record.getMidiChannel();
+	event.noteID = record.getNoteID();
+	event.samplePosition = 0;
+	event.midiPitch = Pitch::fromKey(record.getPitchKey()).getMidiPitch();
+	event.timeSeconds = toSeconds(record.getMicroseconds());
+	event.blockTimeSeconds = event.timeSeconds;
+	return event;
+}
+
+void PerformanceHistory::record(const NoteEvent& event)
+{
+	const uint64_t microseconds = toMicroseconds(event.timeSeconds);
+	const Pitch pitch(event.midiPitch);
+
+	// Bends that don't move the pitch by a whole key aren't worth a record
+	if (event.type == NoteEvent::Type::PitchbendChanged)
+	{
+		std::optional<Pitch> previous = voices.find(event.midiChannel, event.noteID);
+		if (previous.has_value() && *previous == pitch)
+			return;
+	}
+
+	const bool firstEvent = numSnapshots.load(std::memory_order_relaxed) == 0;
+	const bool snapshotDue = firstEvent || snapshotMissing
+		|| (changedSinceSnapshot && microseconds >= lastSnapshotMicroseconds + snapshotIntervalMicroseconds);
+	const uint64_t numRecords = 1 + (snapshotDue ? 1 + (uint64_t)voices.getNumVoices() : 0);
+	const bool fits = hasRoom(endIndex.load(std::memory_order_relaxed) + numRecords);
+	if (fits && snapshotDue)
+		writeSnapshot(microseconds);
+
+	Kind kind = Kind::Added;
+	if (event.type == NoteEvent::Type::Released)
+	{
+		kind = Kind::Released;
+		voices.remove(event.midiChannel, event.noteID);
+	}
+	else
+	{
+		if (event.type == NoteEvent::Type::PitchbendChanged)
+			kind = Kind::PitchbendChanged;
+		voices.remove(event.midiChannel, event.noteID);
+		voices.add(event.midiChannel, event.noteID, pitch);
+	}
+
+	// The voices are still followed while events are skipped, so the snapshot written after
+	// the gap has the right ones
+	if (!fits)
+	{
+		snapshotMissing = true;
+		return;
+	}
+
+	write(kind, event.midiChannel, event.noteID, microseconds, pitch.getKey());
+	changedSinceSnapshot = true;
+}
+
+void PerformanceHistory::writeSnapshot(uint64_t microseconds)
+{
+	const uint64_t snapshot = numSnapshots.load(std::memory_order_relaxed);
+	const uint64_t index = endIndex.load(std::memory_order_relaxed);
+
+	write(Kind::Snapshot, 0, 0, microseconds, voices.getNumVoices());
+	voices.forEachVoice([this, microseconds](uint8_t midiChannel, uint16_t noteID, const Pitch& pitch)
+	{
+		write(Kind::Voice, midiChannel, noteID, microseconds, pitch.getKey());
+	});
+
+	snapshotIndices[snapshot & (numSnapshotSlots - 1)].store(index, std::memory_order_relaxed);
+	numSnapshots.store(snapshot + 1, std::memory_order_release);
+	lastSnapshotMicroseconds = microseconds;
+	changedSinceSnapshot = false;
+	snapshotMissing = false;
+}
+
+void PerformanceHistory::write(Kind kind, uint8_t midiChannel, uint16_t noteID, uint64_t microseconds, int32_t pitchKey)
+{
+	const uint64_t index = endIndex.load(std::memory_order_relaxed);
+	claimedIndex.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	std::atomic<uint64_t>* words = getWords(index);
+	words[0].store(microseconds
+		| (uint64_t)kind << kindShift
+		| (uint64_t)(midiChannel & 0x1f) << channelShift
+		| (uint64_t)noteID << noteIDShift, std::memory_order_relaxed);
+	words[1].store((uint32_t)pitchKey, std::memory_order_relaxed);
+
+	endIndex.store(index + 1, std::memory_order_release);
+}
+
+bool PerformanceHistory::isValid(uint64_t index) const
+{
+	return claimedIndex.load(std::memory_order_relaxed) <= index + capacity;
+}
+
+bool PerformanceHistory::read(uint64_t index, Record& record) const
+{
+	const std::atomic<uint64_t>* words = getWords(index);
+	record.header = words[0].load(std::memory_order_relaxed);
+	record.pitch = words[1].load(std::memory_order_relaxed);
+	// Pairs with the fence in write(): if either word is from a later record, the claim
+	// for it is visible here
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return isValid(index);
+}
+
+uint64_t PerformanceHistory::getBeginIndex() const
+{
+	const uint64_t claimed = claimedIndex.load(std::memory_order_acquire);
+	return claimed > capacity ? claimed - capacity : 0;
+}
+
+uint64_t PerformanceHistory::getEndIndex() const
+{
+	return endIndex.load(std::memory_order_acquire);
+}
+
+uint64_t PerformanceHistory::getSnapshotIndex(uint64_t snapshot) const
+{
+	return snapshotIndices[snapshot & (numSnapshotSlots - 1)].load(std::memory_order_relaxed);
+}
+
+uint64_t PerformanceHistory::findOldestSnapshot() const
+{
+	const uint64_t count = numSnapshots.load(std::memory_order_acquire);
+	uint64_t low = count > numSnapshotSlots ? count - numSnapshotSlots : 0;
+	uint64_t high = count;
+	// Overwritten snapshots are all at the front
+	while (low < high)
+	{
+		const uint64_t middle = low + (high - low) / 2;
+		if (isValid(getSnapshotIndex(middle)))
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	return low;
+}
+
+bool PerformanceHistory::getTimeRange(double& beginSeconds, double& endSeconds) const
+{
+	const uint64_t end = getEndIndex();
+	const uint64_t oldest = findOldestSnapshot();
+	Record first;
+	Record last;
+	if (end == 0 || oldest == numSnapshots.load(std::memory_order_acquire)
+		|| !read(getSnapshotIndex(oldest), first) || !read(end - 1, last))
+		return false;
+
+	beginSeconds = toSeconds(first.getMicroseconds());
+	endSeconds = toSeconds(last.getMicroseconds());
+	return true;
+}
+
+bool PerformanceHistory::reconstruct(double timeSeconds, IntensityModel& model) const
+{
+	model = IntensityModel();
+
+	const uint64_t target = toMicroseconds(timeSeconds);
+	const uint64_t settled = toMicroseconds(timeSeconds - settleSeconds);
+	const uint64_t oldest = findOldestSnapshot();
+	const uint64_t count = numSnapshots.load(std::memory_order_acquire);
+	if (oldest == count)
+		return getBeginIndex() == 0;
+
+	// Latest snapshot old enough that every fade from before it has finished by the sought time
+	uint64_t low = oldest;
+	uint64_t high = count;
+	while (low < high)
+	{
+		const uint64_t middle = low + (high - low) / 2;
+		Record record;
+		if (read(getSnapshotIndex(middle), record) && record.getMicroseconds() > settled)
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	// Near the start of the history there may be no such snapshot. The oldest one is then
+	// only missing the fades of notes released shortly before it, or nothing at all if it's
+	// the very first.
+	const uint64_t snapshot = low > oldest ? low - 1 : oldest;
+
+	const uint64_t snapshotIndex = getSnapshotIndex(snapshot);
+	Record snapshotRecord;
+	if (!read(snapshotIndex, snapshotRecord) || snapshotRecord.getKind() != Kind::Snapshot)
+		return false;
+	if (snapshotRecord.getMicroseconds() > target)
+		return snapshot == 0 && snapshotIndex == 0;
+
+	// Only the voices held settleSeconds before the sought time and the events after that
+	// affect the intensities, so up to there only the held voices are tracked
+	VoiceTable heldVoices;
+	const uint64_t numVoices = (uint32_t)snapshotRecord.pitch;
+	uint64_t index = snapshotIndex + 1;
+	for (; index <= snapshotIndex + numVoices; index++)
+	{
+		Record record;
+		if (!read(index, record))
+			return false;
+		heldVoices.add(record.getMidiChannel(), record.getNoteID(), Pitch::fromKey(record.getPitchKey()));
+	}
+
+	// Near the start of the history the snapshot can be later than that, and the voices have
+	// to start before it instead
+	const double seedSeconds = snapshotRecord.getMicroseconds() <= settled
+		? toSeconds(settled)
+		: toSeconds(snapshotRecord.getMicroseconds()) - settleSeconds;
+	bool seeded = false;
+	auto seed = [&]
+	{
+		heldVoices.forEachVoice([&](uint8_t midiChannel, uint16_t noteID, const Pitch& pitch)
+		{
+			NoteEvent event;
+			event.type = NoteEvent::Type::Added;
+			event.midiChannel = midiChannel;
+			event.noteID = noteID;
+			event.samplePosition = 0;
+			event.midiPitch = pitch.getMidiPitch();
+			event.timeSeconds = seedSeconds;
+			event.blockTimeSeconds = seedSeconds;
+			model.applyNoteEvent(event);
+		});
+		seeded = true;
+	};
+
+	const uint64_t end = getEndIndex();
+	for (; index < end; index++)
+	{
+		Record record;
+		if (!read(index, record))
+			return false;
+		if (record.getMicroseconds() > target)
+			break;
+		const Kind kind = record.getKind();
+		if (kind == Kind::Snapshot || kind == Kind::Voice)
+			continue;
+
+		if (record.getMicroseconds() <= settled)
+		{
+			heldVoices.remove(record.getMidiChannel(), record.getNoteID());
+			if (kind != Kind::Released)
+				heldVoices.add(record.getMidiChannel(), record.getNoteID(), Pitch::fromKey(record.getPitchKey()));
+			continue;
+		}
+
+		if (!seeded)
+			seed();
+		model.applyNoteEvent(toNoteEvent(record));
+	}
+	if (!seeded)
+		seed();
+	return true;
+}
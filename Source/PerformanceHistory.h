@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "IntensityModel.h"
+#include "NoteEventQueue.h"
+#include "VoiceTable.h"
+
+// Every note event since the plugin was loaded, as far back as fits in a ring of 16 byte
+// records. The audio thread records, the message thread reads back and rebuilds past states.
+//
+// The ring starts out as a single chunk and grows a chunk at a time, off the audio thread, up
+// to its capacity. An instance only takes memory for what has been played on it.
+//
+// Every snapshotIntervalSeconds the held voices are written into the ring as well, so rebuilding
+// the state at any instant only replays the events since the snapshot before it.
+class PerformanceHistory
+{
+public:
+	// Must be a power of two. 64 MB once fully grown, a little over an hour at 1000 events
+	// per second.
+	static constexpr uint64_t capacity = uint64_t(1) << 22;
+	// Records the ring grows by at a time, 1 MB. A power of two dividing capacity.
+	static constexpr uint64_t chunkRecords = uint64_t(1) << 16;
+	static constexpr double snapshotIntervalSeconds = 1.0;
+	// How long before the sought time a snapshot must be for every fade to have settled
+	static constexpr double settleSeconds = IntensityModel::noteFadeSeconds + IntensityModel::markerFadeSeconds;
+
+	// Times are stored relative to originSeconds, which must not be after the first event
+	explicit PerformanceHistory(double originSeconds);
+
+	// Audio thread only. Never blocks or allocates. Events are skipped while the ring has no
+	// room for them until grow() catches up.
+	void record(const NoteEvent&);
+	// Allocates another chunk when the one being written is the last one, so there's always a
+	// chunk to spare. One thread, not the audio thread; the processor calls it once a second.
+	void grow();
+
+	// The rest is for a single reader thread.
+	// Index of the oldest record that can still be read, and one past the newest
+	uint64_t getBeginIndex() const;
+	uint64_t getEndIndex() const;
+	// Earliest time that can still be reconstructed and the time of the newest event.
+	// False if nothing was recorded yet.
+	bool getTimeRange(double& beginSeconds, double& endSeconds) const;
+	// Calls callback(const NoteEvent&) for the note events from fromIndex on, in order.
+	// Records overwritten in the meantime are skipped. Returns where to continue from next time.
+	template <typename Callback>
+	uint64_t forEachEvent(uint64_t fromIndex, Callback&&) const;
+	// Replaces the model with the state it had at timeSeconds. Returns false when the history
+	// no longer reaches back that far. The caller still has to update() the model.
+	bool reconstruct(double timeSeconds, IntensityModel&) const;
+private:
+	enum class Kind : uint8_t
+	{
+		Added,
+		PitchbendChanged,
+		Released,
+		// Followed by one Voice record per held voice. The count is in the pitch field.
+		Snapshot,
+		Voice
+	};
+
+	// Two words: time in microseconds, kind, channel and noteID; then the pitch key
+	struct Record
+	{
+		uint64_t header;
+		uint64_t pitch;
+
+		Kind getKind() const;
+		uint8_t getMidiChannel() const;
+		uint16_t getNoteID() const;
+		uint64_t getMicroseconds() const;
+		int32_t getPitchKey() const;
+	};
+
+	static constexpr uint64_t indexMask = capacity - 1;
+	static constexpr uint64_t numChunks = capacity / chunkRecords;
+	// 512 KB, over 18 hours of continuous playing
+	static constexpr uint64_t numSnapshotSlots = uint64_t(1) << 16;
+
+	static NoteEvent::Type toNoteEventType(Kind);
+	uint64_t toMicroseconds(double) const;
+	double toSeconds(uint64_t) const;
+	NoteEvent toNoteEvent(const Record&) const;
+	void write(Kind, uint8_t midiChannel, uint16_t noteID, uint64_t microseconds, int32_t pitchKey);
+	void writeSnapshot(uint64_t microseconds);
+	// Whether the records before index end all fit in the chunks allocated so far
+	bool hasRoom(uint64_t end) const;
+	// First of the two words of the record at index, whose chunk must be allocated
+	std::atomic<uint64_t>* getWords(uint64_t index) const;
+	// False if the record was overwritten before or while it was read
+	bool read(uint64_t index, Record&) const;
+	bool isValid(uint64_t index) const;
+	// Position in snapshotIndices of the oldest snapshot whose records are still readable,
+	// numSnapshots if there is none
+	uint64_t findOldestSnapshot() const;
+	uint64_t getSnapshotIndex(uint64_t snapshot) const;
+
+	double originSeconds;
+	// Two words per record. Allocated in order, each before numChunksAllocated counts it, and
+	// kept until the history is destroyed.
+	std::array<std::unique_ptr<std::atomic<uint64_t>[]>, numChunks> chunks;
+	std::atomic<uint64_t> numChunksAllocated;
+
+	// Writer side
+	VoiceTable voices;
+	uint64_t lastSnapshotMicroseconds;
+	bool changedSinceSnapshot;
+	// Set when events were skipped, so the next one that fits starts with a snapshot
+	bool snapshotMissing;
+
+	// Ring of the record indices snapshots start at, oldest overwritten first
+	std::unique_ptr<std::atomic<uint64_t>[]> snapshotIndices;
+	std::atomic<uint64_t> numSnapshots;
+
+	// Bumped before a record's slot is overwritten, then endIndex once it's complete.
+	// Readers validate against the former, so a torn record is never used.
+	alignas(64) std::atomic<uint64_t> claimedIndex;
+	alignas(64) std::atomic<uint64_t> endIndex;
+};
+
+template <typename Callback>
+uint64_t PerformanceHistory::forEachEvent(uint64_t fromIndex, Callback&& callback) const
+{
+	const uint64_t end = getEndIndex();
+	for (uint64_t index = std::max(fromIndex, getBeginIndex()); index < end; index++)
+	{
+		Record record;
+		if (!read(index, record))
+			continue;
+
+		if (record.getKind() == Kind::Snapshot || record.getKind() == Kind::Voice)
+			continue;
+		callback(toNoteEvent(record));
+	}
+	return end;
+}
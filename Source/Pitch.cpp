@@ -1,38 +1,47 @@
-
+#include <cmath>
 #include <cstdlib>
-#include <JuceHeader.h>
 
 #include "Pitch.h"
 #include "PitchClass.h"
-#include "Hash.h"
 
 Pitch::Pitch(double midiPitch)
 {
-	this->midiPitch = midiPitch;
+	this->key = (int32_t)std::llround(midiPitch * keysPerSemitone);
 }
 
 Pitch Pitch::fromFreqHz(double freqHz)
 {
-	return Pitch(69.f + (log2f(freqHz) - log2f(440)) * 12.f);
+	return Pitch(69.0 + std::log2(freqHz / 440.0) * 12.0);
+}
+
+Pitch Pitch::fromKey(int32_t key)
+{
+	Pitch pitch(0.0);
+	pitch.key = key;
+	return pitch;
 }
 
 Pitch::Pitch(const Pitch& pitch)
 {
-	this->midiPitch = pitch.midiPitch;
+	this->key = pitch.key;
 }
 
 bool Pitch::operator==(const Pitch& pitch) const 
 {
-	return std::abs(this->midiPitch - pitch.midiPitch) < Pitch::epsilon;
+	return key == pitch.key;
 }
 
-
 bool Pitch::operator<(const Pitch& pitch) const
 {
-	return midiPitch < pitch.midiPitch;
+	return key < pitch.key;
 }
 
 double Pitch::getMidiPitch() const 
 {
-	return this->midiPitch;
-}
\ No newline at end of file
+	return (double)key / keysPerSemitone;
+}
+
+int32_t Pitch::getKey() const
+{
+	return key;
+}
@@ -1,31 +1,36 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
-#include <JuceHeader.h>
+#include <functional>
 
 class PitchClass;
 
+// A pitch quantised to 1/1000 cent. Equality, ordering and hashing all use the same integer key,
+// so they always agree with each other.
 class Pitch
 {
 public:
+	// Resolution of pitch keys: 1/1000 cent
+	static constexpr int32_t keysPerSemitone = 100000;
+
 	Pitch(double);
 	Pitch(const Pitch&);
+	Pitch& operator=(const Pitch&) = default;
 	static Pitch fromFreqHz(double);
+	static Pitch fromKey(int32_t);
 	bool operator==(const Pitch&) const;
 	bool operator<(const Pitch&) const;
 	double getMidiPitch() const;
-
-	// Two Pitches are equal if their difference is below this value
-	// 1/1000 cent
-	static constexpr double epsilon = 0.00001; 
-private: 
-	double midiPitch; 
+	int32_t getKey() const;
+private:
+	int32_t key;
 };
 
 struct PitchHash {
 public:
 	size_t operator()(const Pitch& x) const
 	{
-		return std::hash<double>()((int)x.getMidiPitch());
+		return std::hash<int32_t>()(x.getKey());
 	}
-};
\ No newline at end of file
+};
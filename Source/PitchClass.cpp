@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 
 #include "PitchClass.h"
@@ -5,19 +6,23 @@
 
 PitchClass::PitchClass(const Pitch& pitch) 
 {
-	double x = std::fmod(pitch.getMidiPitch(), 12);
-	if (x < 0) x += 12;
-	midiPitchClass = std::abs(x);
+	key = pitch.getKey() % keysPerOctave;
+	if (key < 0) key += keysPerOctave;
 }
 
 PitchClass::PitchClass(const PitchClass& pitchClass)
 {
-	midiPitchClass = pitchClass.midiPitchClass;
+	key = pitchClass.key;
+}
+
+PitchClass PitchClass::fromKey(int32_t key)
+{
+	return PitchClass(Pitch::fromKey(key));
 }
 
 bool PitchClass::operator==(const PitchClass& pitchClass) const
 {
-	return std::abs(this->midiPitchClass - pitchClass.midiPitchClass) < Pitch::epsilon;
+	return key == pitchClass.key;
 }
 
 bool PitchClass::matchesPitch(const Pitch& pitch) const
@@ -28,10 +33,31 @@ bool PitchClass::matchesPitch(const Pitch& pitch) const
 
 bool PitchClass::matchesPitch(const Pitch& pitch, double tolerance) const
 {
-	return std::abs(PitchClass(pitch).midiPitchClass - midiPitchClass) <= std::fmax(Pitch::epsilon, tolerance);
+	return matchesPitchClass(PitchClass(pitch), tolerance);
+}
+
+bool PitchClass::matchesPitchClass(const PitchClass& pitchClass, double tolerance) const
+{
+	return distance(pitchClass.key, key) <= toleranceToKeys(tolerance);
 }
 
 double PitchClass::getCents() const
 {
-	return midiPitchClass * 100;
-}
\ No newline at end of file
+	return key * 0.001;
+}
+
+int32_t PitchClass::getKey() const
+{
+	return key;
+}
+
+int32_t PitchClass::toleranceToKeys(double tolerance)
+{
+	return std::max<int32_t>(0, (int32_t)std::llround(std::min(tolerance, 12.0) * Pitch::keysPerSemitone));
+}
+
+int32_t PitchClass::distance(int32_t a, int32_t b)
+{
+	int32_t d = std::abs(a - b);
+	return std::min(d, keysPerOctave - d);
+}
@@ -1,17 +1,30 @@
 #pragma once
 
+#include <cstdint>
+
 class Pitch;
 
+// A pitch modulo the octave, quantised to the same 1/1000 cent keys as Pitch
 class PitchClass
 {
 public:
+	// Number of distinct keys in an octave
+	static constexpr int32_t keysPerOctave = 12 * 100000;
+
 	PitchClass(const Pitch&);
 	PitchClass(const PitchClass&);
+	static PitchClass fromKey(int32_t);
+	PitchClass& operator=(const PitchClass&) = default;
 	bool matchesPitch(const Pitch&) const;
 	bool matchesPitch (const Pitch&, double) const;
+	bool matchesPitchClass(const PitchClass&, double) const;
 	bool operator==(const PitchClass&) const;
 	double getCents() const;
+	int32_t getKey() const;
+	// Tolerance in semitones as a distance in keys
+	static int32_t toleranceToKeys(double);
+	// Distance between two pitch class keys going whichever way round the octave is shorter
+	static int32_t distance(int32_t, int32_t);
 private:
-	double midiPitchClass;
+	int32_t key;
 };
-
@@ -0,0 +1,37 @@
+#include <algorithm>
+
+#include "IntensityModel.h"
+#include "PitchClassIntensities.h"
+
+PitchClassIntensities::PitchClassIntensities()
+{
+	// One bucket per tracked pitch at most, so update() never has to grow it
+	buckets.reserve(IntensityModel::maxPitches);
+}
+
+void PitchClassIntensities::update(const std::vector<std::pair<Pitch, PitchInfo>>& pitchInfos)
+{
+	buckets.clear();
+
+	for (const std::pair<Pitch, PitchInfo>& pair : pitchInfos)
+		buckets.push_back(Bucket{ PitchClass(pair.first).getKey(), pair.second });
+
+	std::sort(buckets.begin(), buckets.end(),
+		[](const Bucket& a, const Bucket& b) { return a.key < b.key; });
+
+	// Merge runs of equal keys in place
+	size_t merged = 0;
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		if (merged > 0 && buckets[merged - 1].key == buckets[i].key)
+			buckets[merged - 1].intensity.mergeMax(buckets[i].intensity);
+		else
+			buckets[merged++] = buckets[i];
+	}
+	buckets.resize(merged);
+}
+
+const std::vector<PitchClassIntensities::Bucket>& PitchClassIntensities::getBuckets() const
+{
+	return buckets;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Pitch.h"
+#include "PitchClass.h"
+#include "PitchInfo.h"
+
+// Per-frame aggregation of pitch intensities by pitch class.
+// All pitches sharing a pitch class are merged into one record holding the
+// maximum note/top/bass intensity, kept sorted by pitch class key so LatticeIndex
+// only looks at the cells within the tolerance of each bucket.
+class PitchClassIntensities
+{
+public:
+	struct Bucket
+	{
+		int32_t key;
+		PitchInfo intensity;
+	};
+
+	PitchClassIntensities();
+	void update(const std::vector<std::pair<Pitch, PitchInfo>>&);
+	// One bucket per sounding pitch class, sorted by key
+	const std::vector<Bucket>& getBuckets() const;
+private:
+	std::vector<Bucket> buckets;
+};
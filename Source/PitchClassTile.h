@@ -4,6 +4,9 @@
 #include "Hash.h"
 #include "Pitch.h"
 #include "PitchInfo.h"
+#include "TileDescriptor.h"
+#include "TileStyle.h"
+#include "LabelImageCache.h"
 
 class Pitch;
 class PitchClass;
@@ -12,27 +15,25 @@ class PitchClassTile :
 	public juce::Component
 {
 public:
-	PitchClassTile(int, int, int, double, double, double, double);
-	void setTuning(int, int, int, double, double, double, double);
+	// Layer 0 is a labelled main cell, -1 and 1 are corner cells along the projection's depth axis
+	PitchClassTile(LabelImageCache&, int layer);
+	void setDescriptor(const TileDescriptor&);
 	void paint(juce::Graphics& g) override;
-	void updatePitchIntensities(const std::map<Pitch, PitchInfo>&);
-	void timerUpdate();
+	void resized() override;
+	void setIntensity(const PitchInfo&);
+	// Repaints the tile if its visual state changed. Returns whether it did.
+	bool timerUpdate();
 private:
-	PitchClass pitchClass;
-	double tolerance;
-	std::map<Pitch, PitchInfo> pitchInfos;
+	void prepareLabels();
+
+	LabelImageCache& labelImageCache;
+	// Display scale of the last paint, used to render labels ahead of time
+	float labelScale;
+	TileDescriptor descriptor;
+	// Max intensities of all sounding pitches matching this tile's pitch class
+	PitchInfo intensity;
+	TileStyle::VisualState visualState;
 	bool needsRepaint;
 	juce::Colour pitchColor(Pitch, double);
-	juce::String pitchName;
-	juce::String accidentals;
-	juce::String syntonicCommas;
-	int factor3Base;
-	int factor5Base;
-	int factor7Base;
-	int factor3Offset;
-	int factor5Offset;
-	int factor7Offset;
-	bool septimalMeantone;
-	bool meantone;
+	int layer;
 };
-
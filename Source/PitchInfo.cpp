@@ -1,7 +1,15 @@
+#include <algorithm>
+
 #include "PitchInfo.h"
-#pragma once
 
 PitchInfo::PitchInfo() : noteIntensity(0.0), topIntensity(0.0), bassIntensity(0.0) {}
 
 PitchInfo::PitchInfo(double noteIntensity, double topIntensity, double bassIntensity) :
-	topIntensity(topIntensity), bassIntensity(bassIntensity), noteIntensity(noteIntensity) {}
\ No newline at end of file
+	topIntensity(topIntensity), bassIntensity(bassIntensity), noteIntensity(noteIntensity) {}
+
+void PitchInfo::mergeMax(const PitchInfo& other)
+{
+	noteIntensity = std::max(noteIntensity, other.noteIntensity);
+	topIntensity = std::max(topIntensity, other.topIntensity);
+	bassIntensity = std::max(bassIntensity, other.bassIntensity);
+}
@@ -4,6 +4,8 @@ class PitchInfo
 public:
 	PitchInfo();
 	PitchInfo(double, double, double);
+	// Keeps the larger of each intensity, for pitches that land on the same pitch class or cell
+	void mergeMax(const PitchInfo&);
 	double topIntensity;
 	double bassIntensity;
 	double noteIntensity;
@@ -13,20 +13,59 @@
 #include "Pitch.h"
 #include "PitchClassTile.h"
 #include "Hash.h"
+#include "MPENoteEvents.h"
+#include "ScalaState.h"
+
+namespace {
+// Choices of the replay speed menu, in item ID order
+const std::array<double, 6> replaySpeeds = { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0 };
+// Parameter holding the offset along each lattice axis, in LatticeAxis order
+const std::array<const char*, 4> offsetParameterIDs = { "LATTICE_FACTOR_3", "LATTICE_FACTOR_5", "LATTICE_FACTOR_7", "LATTICE_W" };
+// The narrower offsets of older versions, which add to the first three
+const std::array<const char*, 3> legacyOffsetParameterIDs = { "LATTICE_Y", "LATTICE_X", "LATTICE_Z" };
+// Zoom of the lattice, saved with the parameters
+const juce::Identifier tileSizeProperty("TILE_SIZE");
+const int defaultTileSize = 70;
+// Rate the stopped frame scheduler checks for note events at. Low enough that an idle editor
+// costs next to nothing, at the price of the first note after a pause showing up to 200 ms late.
+const double idlePollHz = 5.0;
+
+// As "name: p50 / p99 / max unit", with the values multiplied by scale
+juce::String formatDistribution(const juce::String& name, const LogHistogram& histogram, double scale,
+    int decimals, const juce::String& unit)
+{
+    return name + ": " + juce::String(histogram.getPercentile(0.5) * scale, decimals)
+        + " / " + juce::String(histogram.getPercentile(0.99) * scale, decimals)
+        + " / " + juce::String(histogram.getMax() * scale, decimals) + unit;
+}
+}
 
 //==============================================================================
 PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrument):
     AudioProcessorEditor (&p), 
     audioProcessor (p), 
-    mpeInstrument(mpeInstrument)
+    latticeView(sharedResources->getLabelImageCache()),
+    useLatticeView(false),
+    lastNumDroppedEvents(0),
+    pendingEvent(),
+    hasPendingEvent(false),
+    frameTimerRunning(false),
+    frameScheduler(*this, [this](double) { return renderFrame(); }),
+    lastFrameStatsTime(getTimeSeconds()),
+    scrubModelStale(false),
+    pendingTuning(),
+    tuningChanged(false),
+    submittedHarmonySequence(0),
+    shownHarmonySequence(0),
+    mpeInstrument(mpeInstrument),
+    lastNumMidiMessages(p.getCounters().numMidiMessages.load()),
+    lastTimelineUpdateTime(0)
 {
-    getLookAndFeel().setDefaultSansSerifTypefaceName("Helvetica");
-
     mpeInstrument.addListener(this);
 
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize(870, 930);
+    setSize(870, 1050);
 
     //addAndMakeVisible(logBox);
     logBox.setMultiLine(true);
@@ -43,24 +82,31 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrume
     logBox.moveCaretToEnd();
     logBox.insertTextAtCaret("2");
 
-    /*
+    harmonyLabel.setFont(juce::Font(16, juce::Font::bold));
+    harmonyLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(harmonyLabel);
+
     addAndMakeVisible(tuningMenu);
-    tuningMenu.addItem("12-tet", 1);
-    tuningMenu.addItem("31-tet", 2);
-    tuningMenu.addItem("53-tet", 3);
-    tuningMenu.addItem("5-limit JI", 4);
-    tuningMenu.onChange = [this] { tuningChanged(); };
-    tuningMenu.setSelectedId(1);
-    */
+    for (int i = 0; i < (int)TuningPresets::presets.size(); i++)
+        tuningMenu.addItem(TuningPresets::presets[i].name, i + 1);
+    tuningMenu.setTextWhenNothingSelected("Custom tuning");
+    tuningMenu.onChange = [this] { tuningPresetChanged(); };
+
+    addAndMakeVisible(projectionMenu);
+    for (int i = 0; i < (int)LatticeProjections::projections.size(); i++)
+        projectionMenu.addItem(LatticeProjections::projections[i].name, i + 1);
+    projectionAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        audioProcessor.apvts, "PROJECTION", projectionMenu);
+    projectionMenu.onChange = [this] { projectionChanged(); };
 
     juce::Font labelFont(16);
     latticeXLabel.setFont(labelFont);
-    latticeXLabel.setText("Horizontal (Major third) offset", juce::dontSendNotification);
+    latticeXLabel.setText("Major third offset", juce::dontSendNotification);
     latticeXLabel.setJustificationType(juce::Justification::left);
     addAndMakeVisible(latticeXLabel);
 
     latticeYLabel.setFont(labelFont);
-    latticeYLabel.setText("Vertical (Perfect fifth) offset", juce::dontSendNotification);
+    latticeYLabel.setText("Perfect fifth offset", juce::dontSendNotification);
     latticeYLabel.setJustificationType(juce::Justification::left);
     addAndMakeVisible(latticeYLabel);
 
@@ -69,6 +115,12 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrume
     latticeZLabel.setJustificationType(juce::Justification::left);
     addAndMakeVisible(latticeZLabel);
 
+    // Axes off the projection's plane are sliced at their offset
+    latticeWLabel.setFont(labelFont);
+    latticeWLabel.setText("Undecimal tritone offset", juce::dontSendNotification);
+    latticeWLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(latticeWLabel);
+
     centsFactor3Label.setFont(labelFont);
     centsFactor3Label.setText("Perfect fifth (cents)", juce::dontSendNotification);
     centsFactor3Label.setJustificationType(juce::Justification::left);
@@ -84,11 +136,114 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrume
     centsFactor7Label.setJustificationType(juce::Justification::left);
     addAndMakeVisible(centsFactor7Label);
 
+    centsFactor11Label.setFont(labelFont);
+    centsFactor11Label.setText("Undecimal tritone (cents)", juce::dontSendNotification);
+    centsFactor11Label.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(centsFactor11Label);
+
     toleranceLabel.setFont(labelFont);
     toleranceLabel.setText("Tolerance (cents)", juce::dontSendNotification);
     toleranceLabel.setJustificationType(juce::Justification::left);
     addAndMakeVisible(toleranceLabel);
 
+    droppedEventsLabel.setFont(labelFont);
+    droppedEventsLabel.setText("Dropped events: 0", juce::dontSendNotification);
+    droppedEventsLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(droppedEventsLabel);
+
+    frameStatsLabel.setFont(labelFont);
+    frameStatsLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(frameStatsLabel);
+
+    instrumentationOverlay.setFont(juce::Font(14));
+    instrumentationOverlay.setJustificationType(juce::Justification::topLeft);
+    instrumentationOverlay.setColour(juce::Label::backgroundColourId, juce::Colours::black.withAlpha(0.75f));
+    instrumentationOverlay.setColour(juce::Label::textColourId, juce::Colours::white);
+    instrumentationOverlay.setInterceptsMouseClicks(false, false);
+
+    instrumentationButton.setButtonText("Timings");
+    instrumentationButton.onClick = [this]
+    {
+        instrumentationOverlay.setVisible(instrumentationButton.getToggleState());
+        updateInstrumentationOverlay();
+    };
+    addAndMakeVisible(instrumentationButton);
+
+    exportCountersButton.setButtonText("Export...");
+    exportCountersButton.onClick = [this] { exportCounters(); };
+    addAndMakeVisible(exportCountersButton);
+
+    resetCountersButton.setButtonText("Reset");
+    resetCountersButton.onClick = [this]
+    {
+        audioProcessor.getCounters().reset();
+        updateInstrumentationOverlay();
+    };
+    addAndMakeVisible(resetCountersButton);
+    updateFrameStats();
+
+    rendererLabel.setFont(labelFont);
+    rendererLabel.setText("Renderer", juce::dontSendNotification);
+    rendererLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(rendererLabel);
+
+    rendererMenu.addItem("Tile components", 1);
+    rendererMenu.addItem("Batched lattice", 2);
+    rendererMenu.setSelectedId(1, juce::dontSendNotification);
+    rendererMenu.onChange = [this] { rendererChanged(); };
+    addAndMakeVisible(rendererMenu);
+
+    scalaLabel.setFont(labelFont);
+    scalaLabel.setText("Scala scale", juce::dontSendNotification);
+    scalaLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(scalaLabel);
+
+    loadScaleButton.setButtonText("Load .scl");
+    loadScaleButton.onClick = [this] { chooseScalaFile(false); };
+    addAndMakeVisible(loadScaleButton);
+
+    loadKeyboardMappingButton.setButtonText("Load .kbm");
+    loadKeyboardMappingButton.onClick = [this] { chooseScalaFile(true); };
+    addAndMakeVisible(loadKeyboardMappingButton);
+
+    clearScaleButton.setButtonText("Clear");
+    clearScaleButton.onClick = [this] { setScalaFiles({}, {}); };
+    addAndMakeVisible(clearScaleButton);
+
+    scalaStatusLabel.setFont(juce::Font(14));
+    scalaStatusLabel.setJustificationType(juce::Justification::topLeft);
+    addAndMakeVisible(scalaStatusLabel);
+
+    timelineView.onScrub = [this](std::optional<double> time) { scrubTimeChanged(time); };
+    timelineView.update(audioProcessor.getHistory(), getTimeSeconds());
+    addAndMakeVisible(timelineView);
+
+    recordLogButton.onClick = [this] { toggleEventLogRecording(); };
+    addAndMakeVisible(recordLogButton);
+
+    openLogButton.setButtonText("Open log...");
+    openLogButton.onClick = [this] { chooseEventLogToReplay(); };
+    addAndMakeVisible(openLogButton);
+
+    replayButton.onClick = [this] { toggleReplay(); };
+    addAndMakeVisible(replayButton);
+
+    for (int i = 0; i < (int)replaySpeeds.size(); i++)
+        replaySpeedMenu.addItem(juce::String(replaySpeeds[i]) + "x", i + 1);
+    replaySpeedMenu.setSelectedId(3, juce::dontSendNotification);
+    addAndMakeVisible(replaySpeedMenu);
+
+    replayPositionSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    replayPositionSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 70, 26);
+    replayPositionSlider.setTextValueSuffix(" s");
+    replayPositionSlider.setRange(0.0, 1.0, 0.1);
+    addAndMakeVisible(replayPositionSlider);
+
+    eventLogStatusLabel.setFont(juce::Font(14));
+    eventLogStatusLabel.setJustificationType(juce::Justification::left);
+    addAndMakeVisible(eventLogStatusLabel);
+    updateEventLogControls();
+
     factor3ToFactor5Label.setFont(labelFont);
     factor3ToFactor5Label.setText("Set major third in terms of fifths", juce::dontSendNotification);
     factor3ToFactor5Label.setJustificationType(juce::Justification::right);
@@ -111,6 +266,10 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrume
     latticeZSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
     addAndMakeVisible(latticeZSlider);
 
+    latticeWSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    latticeWSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
+    addAndMakeVisible(latticeWSlider);
+
     centsFactor3Slider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
     centsFactor3Slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
     addAndMakeVisible(centsFactor3Slider);
@@ -123,99 +282,362 @@ PluginEditor::PluginEditor (PluginProcessor& p, juce::MPEInstrument& mpeInstrume
     centsFactor7Slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
     addAndMakeVisible(centsFactor7Slider);
 
+    centsFactor11Slider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    centsFactor11Slider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
+    addAndMakeVisible(centsFactor11Slider);
+
     toleranceSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
     toleranceSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 50);
     addAndMakeVisible(toleranceSlider);
 
     latticeXAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-        audioProcessor.apvts, "LATTICE_X", latticeXSlider);
+        audioProcessor.apvts, "LATTICE_FACTOR_5", latticeXSlider);
     latticeYAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-        audioProcessor.apvts, "LATTICE_Y", latticeYSlider);
+        audioProcessor.apvts, "LATTICE_FACTOR_3", latticeYSlider);
     latticeZAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-        audioProcessor.apvts, "LATTICE_Z", latticeZSlider);
+        audioProcessor.apvts, "LATTICE_FACTOR_7", latticeZSlider);
+    for (size_t i = 0; i < legacyOffsetSliders.size(); i++)
+        legacyOffsetAttachments[i] = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+            audioProcessor.apvts, legacyOffsetParameterIDs[i], legacyOffsetSliders[i]);
+    latticeWAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.apvts, "LATTICE_W", latticeWSlider);
     centsFactor3Attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.apvts, "CENTS_FACTOR_3", centsFactor3Slider);
     centsFactor5Attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.apvts, "CENTS_FACTOR_5", centsFactor5Slider);
     centsFactor7Attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.apvts, "CENTS_FACTOR_7", centsFactor7Slider);
+    centsFactor11Attachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.apvts, "CENTS_FACTOR_11", centsFactor11Slider);
     toleranceAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.apvts, "CENTS_TOLERANCE", toleranceSlider);
 
     float centsFactor3 = audioProcessor.apvts.getRawParameterValue("CENTS_FACTOR_3")->load();
     float centsFactor5 = audioProcessor.apvts.getRawParameterValue("CENTS_FACTOR_5")->load();
     float centsFactor7 = audioProcessor.apvts.getRawParameterValue("CENTS_FACTOR_7")->load();
-    int latticeX = std::round(audioProcessor.apvts.getRawParameterValue("LATTICE_X")->load());
-    int latticeY = std::round(audioProcessor.apvts.getRawParameterValue("LATTICE_Y")->load());
-    int latticeZ = std::round(audioProcessor.apvts.getRawParameterValue("LATTICE_Z")->load());
+    float centsFactor11 = audioProcessor.apvts.getRawParameterValue("CENTS_FACTOR_11")->load();
+    int projection = std::round(audioProcessor.apvts.getRawParameterValue("PROJECTION")->load());
     float tolerance = audioProcessor.apvts.getRawParameterValue("CENTS_TOLERANCE")->load();
 
-    int size = 70;
-    int smallWidth = 24;
-    int smallHeight = 24;
-    for (int x = 0; x <= 8; x++)
+    latticeViewport.setTileSize(audioProcessor.apvts.state.getProperty(tileSizeProperty, defaultTileSize));
+    latticeViewport.onPan = [this](int horizontalDelta, int verticalDelta) { panLattice(horizontalDelta, verticalDelta); };
+    latticeViewport.onRecentre = [this]
     {
-        for (int y = 0; y <= 12; y++)
-        {
-            int xPos = 10 + x * size;
-            int yPos = 10 + y * size;
-            int factor3 = -(y - 6);
-            int factor5 = x - 4;
-
-            PitchClassTile* newTile = new PitchClassTile(
-                factor3 + latticeY, factor5 + latticeX, 0, 
-                centsFactor3 * 0.01, centsFactor5 * 0.01, centsFactor7 * 0.01, 
-                tolerance * 0.01);
-            newTile->setBounds(xPos, yPos, size, size);
-
-            PitchClassTile* upTile = new PitchClassTile(
-                factor3 + latticeY, factor5 + latticeX, 1,
-                centsFactor3 * 0.01, centsFactor5 * 0.01, centsFactor7 * 0.01,
-                tolerance * 0.01);
-            upTile->setBounds(xPos + size - smallWidth, yPos, smallWidth, smallHeight);
-
-            PitchClassTile* downTile = new PitchClassTile(
-                factor3 + latticeY, factor5 + latticeX, -1,
-                centsFactor3 * 0.01, centsFactor5 * 0.01, centsFactor7 * 0.01,
-                tolerance * 0.01);
-            downTile->setBounds(xPos + size - smallWidth, yPos + size - smallHeight, smallWidth, smallHeight);
-
-            tiles.push_back(std::unique_ptr<PitchClassTile>(newTile));
-            tiles.push_back(std::unique_ptr<PitchClassTile>(upTile));
-            tiles.push_back(std::unique_ptr<PitchClassTile>(downTile));
-            addAndMakeVisible(*newTile);
-            addAndMakeVisible(*upTile);
-            addAndMakeVisible(*downTile);
-        }
-    }
+        for (const char* parameterID : offsetParameterIDs)
+            setLatticeOffset(parameterID, 0);
+        for (const char* parameterID : legacyOffsetParameterIDs)
+            setLatticeOffset(parameterID, 0);
+    };
+    latticeViewport.onZoom = [this](int newTileSize)
+    {
+        audioProcessor.apvts.state.setProperty(tileSizeProperty, newTileSize, nullptr);
+        rebuildCells();
+    };
+    addAndMakeVisible(latticeViewport);
+    latticeView.setInterceptsMouseClicks(false, false);
+    latticeViewport.addChildComponent(latticeView);
+    // Added after the viewport, so it's drawn over the cells
+    addChildComponent(instrumentationOverlay);
+
+    pendingTuning = TuningParameters{
+        getLatticeOffset(LatticeAxis::factor3), getLatticeOffset(LatticeAxis::factor5),
+        getLatticeOffset(LatticeAxis::factor7), getLatticeOffset(LatticeAxis::factor11), projection,
+        centsFactor3 * 0.01, centsFactor5 * 0.01, centsFactor7 * 0.01, centsFactor11 * 0.01,
+        tolerance * 0.01, 0 };
+    loadScalaFromState();
+    rebuildCells();
+    updateTuningMenu();
 
     latticeXSlider.addListener(this);
     latticeYSlider.addListener(this);
     latticeZSlider.addListener(this);
+    latticeWSlider.addListener(this);
+    for (juce::Slider& slider : legacyOffsetSliders)
+        slider.addListener(this);
     centsFactor3Slider.addListener(this);
     centsFactor5Slider.addListener(this);
     centsFactor7Slider.addListener(this);
+    centsFactor11Slider.addListener(this);
     toleranceSlider.addListener(this);
+    audioProcessor.apvts.state.addListener(this);
 
-    startTimerHz(60);
+    frameScheduler.setIdleHz(idlePollHz);
+    startFrameTimer();
 }
 
+// Slider drags and host automation can fire many times per frame, so this only records the
+// new tuning. The next frame rebuilds the descriptors once for all of them.
 void PluginEditor::sliderValueChanged(juce::Slider* slider)
 {
-    float centsFactor3 = centsFactor3Slider.getValue();
-    float centsFactor5 = centsFactor5Slider.getValue();
-    float centsFactor7 = centsFactor7Slider.getValue();
-    int latticeX = latticeXSlider.getValue();
-    int latticeY = latticeYSlider.getValue();
-    int latticeZ = latticeZSlider.getValue();
-    float tolerance = toleranceSlider.getValue();
-    for (auto& tile : tiles)
+    pendingTuning = TuningParameters{
+        getLatticeOffset(LatticeAxis::factor3), getLatticeOffset(LatticeAxis::factor5),
+        getLatticeOffset(LatticeAxis::factor7), getLatticeOffset(LatticeAxis::factor11), pendingTuning.projection,
+        centsFactor3Slider.getValue() * 0.01, centsFactor5Slider.getValue() * 0.01, centsFactor7Slider.getValue() * 0.01,
+        centsFactor11Slider.getValue() * 0.01, toleranceSlider.getValue() * 0.01, pendingTuning.scaleHash };
+    tuningChanged = true;
+    updateTuningMenu();
+
+    startFrameTimer();
+}
+
+// Sets the interval parameters to the chosen preset. The slider attachments then call
+// sliderValueChanged, which schedules the rebuild like any other tuning change.
+void PluginEditor::tuningPresetChanged()
+{
+    int index = tuningMenu.getSelectedId() - 1;
+    if (index < 0 || index >= (int)TuningPresets::presets.size())
+        return;
+
+    const TuningInfo& tuning = TuningPresets::presets[index].tuning;
+    auto setCents = [this](const char* parameterID, double semitones)
+    {
+        juce::RangedAudioParameter* parameter = audioProcessor.apvts.getParameter(parameterID);
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(parameter->convertTo0to1((float)(semitones * 100.0)));
+        parameter->endChangeGesture();
+    };
+    setCents("CENTS_FACTOR_3", tuning.getSemisFactor3());
+    setCents("CENTS_FACTOR_5", tuning.getSemisFactor5());
+    setCents("CENTS_FACTOR_7", tuning.getSemisFactor7());
+    setCents("CENTS_FACTOR_11", tuning.getSemisFactor11());
+}
+
+// Shows the preset matching the current intervals, if any
+void PluginEditor::updateTuningMenu()
+{
+    int index = TuningPresets::find(pendingTuning.semisFactor3, pendingTuning.semisFactor5,
+        pendingTuning.semisFactor7, pendingTuning.semisFactor11);
+    tuningMenu.setSelectedId(index + 1, juce::dontSendNotification);
+}
+
+void PluginEditor::chooseScalaFile(bool keyboardMapping)
+{
+    scalaFileChooser = std::make_unique<juce::FileChooser>(
+        keyboardMapping ? "Load Scala keyboard mapping" : "Load Scala scale",
+        juce::File(), keyboardMapping ? "*.kbm" : "*.scl");
+    scalaFileChooser->launchAsync(
+        juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [this, keyboardMapping](const juce::FileChooser& chooser)
+        {
+            juce::File file = chooser.getResult();
+            if (file == juce::File())
+                return;
+
+            juce::ValueTree state = ScalaState::get(audioProcessor.apvts.state);
+            if (keyboardMapping)
+                setScalaFiles(ScalaState::getScaleText(state), file.loadFileAsString());
+            else
+                setScalaFiles(file.loadFileAsString(), {});
+        });
+}
+
+// Checks the files before storing them, so a bad file leaves the current scale in place
+void PluginEditor::setScalaFiles(const juce::String& scl, const juce::String& kbm)
+{
+    ScalaScale scale;
+    std::string error;
+    if (scl.isNotEmpty())
+        error = scale.parseScale(scl.toStdString());
+    if (error.empty() && kbm.isNotEmpty())
+        error = scale.parseKeyboardMapping(kbm.toStdString());
+    if (!error.empty())
+    {
+        scalaError = error;
+        updateScalaLabel();
+        return;
+    }
+
+    juce::ValueTree state = ScalaState::get(audioProcessor.apvts.state);
+    ScalaState::setFiles(state, scl, kbm);
+    loadScalaFromState();
+}
+
+// Picks up the scale stored in the parameter state. The mapping is solved, or taken from the
+// state, when the descriptors are rebuilt on the next frame.
+void PluginEditor::loadScalaFromState()
+{
+    scalaError = ScalaState::loadScale(ScalaState::get(audioProcessor.apvts.state), scalaScale);
+    scalaMapping = ScalaMapping();
+    pendingTuning.scaleHash = scalaScale.getHash();
+    tuningChanged = true;
+    updateScalaLabel();
+    startFrameTimer();
+}
+
+// The host restored a saved state, possibly with a different scale or zoom
+void PluginEditor::valueTreeRedirected(juce::ValueTree&)
+{
+    loadScalaFromState();
+
+    int previousTileSize = latticeViewport.getTileSize();
+    latticeViewport.setTileSize(audioProcessor.apvts.state.getProperty(tileSizeProperty, defaultTileSize));
+    if (latticeViewport.getTileSize() != previousTileSize)
+        rebuildCells();
+}
+
+// Makes scalaMapping match the scale and pendingTuning. Solving is skipped when the saved
+// state already holds a mapping for them, which matters for scales with many degrees. A new
+// mapping is only kept here; the processor stores one when the state is saved.
+void PluginEditor::updateScalaMapping()
+{
+    if (scalaScale.isEmpty())
+    {
+        scalaMapping = ScalaMapping();
+        return;
+    }
+
+    uint64_t hash = pendingTuning.scaleHash;
+    double s3 = pendingTuning.semisFactor3;
+    double s5 = pendingTuning.semisFactor5;
+    double s7 = pendingTuning.semisFactor7;
+    if (scalaMapping.isSolvedFor(hash, s3, s5, s7))
+        return;
+
+    std::optional<ScalaMapping> stored = ScalaState::loadMapping(ScalaState::get(audioProcessor.apvts.state));
+    if (stored.has_value() && stored->isSolvedFor(hash, s3, s5, s7))
+        scalaMapping = std::move(*stored);
+    else
+        scalaMapping = ScalaMapping::solve(scalaScale, s3, s5, s7);
+    updateScalaLabel();
+}
+
+void PluginEditor::updateScalaLabel()
+{
+    juce::String text;
+    if (scalaError.isNotEmpty())
+    {
+        text = scalaError;
+    }
+    else if (scalaScale.isEmpty())
+    {
+        text = "None loaded";
+    }
+    else
     {
-        tile->setTuning(
-            latticeY, latticeX, latticeZ,
-            centsFactor3 * 0.01, centsFactor5 * 0.01, centsFactor7 * 0.01, 
-            tolerance * 0.01);
+        double maxErrorCents = 0;
+        for (const ScaleDegreeMapping& degree : scalaMapping.getDegrees())
+            maxErrorCents = std::max(maxErrorCents, degree.errorCents);
+
+        juce::String description(scalaScale.getDescription());
+        text = (description.isEmpty() ? juce::String("Untitled") : description) + "\n"
+            + juce::String(scalaScale.getNumDegrees()) + " notes, max error "
+            + juce::String(maxErrorCents, 1) + " cents";
     }
+    scalaStatusLabel.setText(text, juce::dontSendNotification);
+}
+
+// Builds the whole grid's descriptors for pendingTuning and swaps them in at once. New cells
+// have no descriptors yet, so they're given the table even when it's the one already shown.
+void PluginEditor::rebuildDescriptors(bool newCells)
+{
+    tuningChanged = false;
+    updateScalaMapping();
+
+    if (!newCells && descriptorTable != nullptr && descriptorTable->isBuiltFrom(cellBases, pendingTuning))
+        return;
+
+    // Switching back to a recent tuning, like flipping between presets, or to one another
+    // instance shows already, reuses its table
+    std::shared_ptr<const DescriptorTable> table = sharedResources->getDescriptorTable(
+        cellBases, pendingTuning, descriptorTable.get(), scalaScale.isEmpty() ? nullptr : &scalaMapping);
+    descriptorTable = table;
+
+    for (size_t i = 0; i < tiles.size(); i++)
+        tiles[i]->setDescriptor(table->getDescriptor((int)i));
+    latticeView.setDescriptors(*table);
+    latticeIndex.rebuild(*table);
+}
+
+// The projection menu's attachment has already set the parameter
+void PluginEditor::projectionChanged()
+{
+    int projection = projectionMenu.getSelectedItemIndex();
+    if (projection < 0 || projection == pendingTuning.projection)
+        return;
+    pendingTuning.projection = projection;
+    rebuildCells();
+}
+
+// Creates the cells overlapping the viewport at its tile size, on the projection's plane and one
+// step either way along its depth axis. Panning and slicing only change the offsets they're
+// shown with, so however far and in however many dimensions the lattice extends, the number of
+// cells and the cost of a frame only depend on the viewport's size and zoom.
+void PluginEditor::rebuildCells()
+{
+    tiles.clear();
+    latticeView.clearCells();
+    cellBases.clear();
+
+    const LatticeProjection& projection = LatticeProjections::get(pendingTuning.projection);
+    for (const LatticeCell& cell : LatticeRenderer::createCells(latticeViewport.getTileSize(), latticeViewport.getLocalBounds(), projection))
+    {
+        PitchClassTile* tile = new PitchClassTile(sharedResources->getLabelImageCache(), cell.layer);
+        tile->setBounds(cell.bounds);
+        // Drags over the tiles pan the viewport
+        tile->setInterceptsMouseClicks(false, false);
+
+        latticeView.addCell(cell.bounds, cell.base, cell.layer);
+        cellBases.push_back(cell.base);
+
+        tiles.push_back(std::unique_ptr<PitchClassTile>(tile));
+        latticeViewport.addChildComponent(*tile);
+        tile->setVisible(!useLatticeView);
+    }
+
+    rebuildDescriptors(true);
+    startFrameTimer();
+}
+
+// Moves the offset parameters of the projection's plane like their sliders do, so pans are
+// saved and seen by the host
+void PluginEditor::panLattice(int horizontalDelta, int verticalDelta)
+{
+    const LatticeProjection& projection = LatticeProjections::get(pendingTuning.projection);
+    auto move = [this](LatticeAxis axis, int delta)
+    {
+        if (delta == 0)
+            return;
+        const char* parameterID = offsetParameterIDs[(size_t)axis];
+        setLatticeOffset(parameterID, (int)std::round(audioProcessor.apvts.getRawParameterValue(parameterID)->load()) + delta);
+    };
+    move(projection.horizontal, horizontalDelta);
+    move(projection.vertical, verticalDelta);
+}
+
+// The offset slider's value plus the legacy offset, if the axis has one, kept within the lattice
+int PluginEditor::getLatticeOffset(LatticeAxis axis) const
+{
+    const juce::Slider* sliders[] = { &latticeYSlider, &latticeXSlider, &latticeZSlider, &latticeWSlider };
+    const juce::Slider& slider = *sliders[(size_t)axis];
+    int offset = (int)slider.getValue();
+    if ((size_t)axis < legacyOffsetSliders.size())
+        offset += (int)legacyOffsetSliders[(size_t)axis].getValue();
+    return juce::jlimit((int)slider.getMinimum(), (int)slider.getMaximum(), offset);
+}
+
+void PluginEditor::setLatticeOffset(const char* parameterID, int offset)
+{
+    juce::RangedAudioParameter* parameter = audioProcessor.apvts.getParameter(parameterID);
+    parameter->beginChangeGesture();
+    parameter->setValueNotifyingHost(parameter->convertTo0to1((float)offset));
+    parameter->endChangeGesture();
+}
+
+void PluginEditor::rendererChanged()
+{
+    useLatticeView = rendererMenu.getSelectedId() == 2;
+
+    for (const std::unique_ptr<PitchClassTile>& pitchClassTile : tiles)
+    {
+        pitchClassTile->setVisible(!useLatticeView);
+    }
+    latticeView.setVisible(useLatticeView);
+
+    // The newly visible renderer missed the changes made while it was hidden
+    for (int cell = 0; cell < latticeIndex.getNumCells(); cell++)
+        setCellIntensity(cell);
+
+    startFrameTimer();
 }
 
 void PluginEditor::initInputLabel(juce::Label& label)
@@ -233,43 +655,203 @@ void PluginEditor::resized()
     //logBox.setBounds(10, 10, getWidth() - 20, 190);
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
-   // tuningMenu.setBounds(xStart, 10, 200, 30);
-
-    latticeYLabel.setBounds(xStart, 100, 200, 30);
-    latticeYSlider.setBounds(xStart, 130, 200, 30);
+    latticeViewport.setBounds(LatticeRenderer::getCellsBounds(defaultTileSize).withTrimmedLeft(10).withTrimmedTop(10));
+    latticeView.setBounds(latticeViewport.getLocalBounds());
+
+    harmonyLabel.setBounds(xStart, 5, 200, 30);
+    tuningMenu.setBounds(xStart, 38, 200, 28);
+    projectionMenu.setBounds(xStart, 70, 200, 28);
+
+    juce::Label* sliderLabels[] = { &latticeYLabel, &latticeXLabel, &latticeZLabel, &latticeWLabel,
+        &centsFactor3Label, &centsFactor5Label, &centsFactor7Label, &centsFactor11Label, &toleranceLabel };
+    juce::Slider* sliders[] = { &latticeYSlider, &latticeXSlider, &latticeZSlider, &latticeWSlider,
+        &centsFactor3Slider, &centsFactor5Slider, &centsFactor7Slider, &centsFactor11Slider, &toleranceSlider };
+    for (int i = 0; i < 9; i++)
+    {
+        sliderLabels[i]->setBounds(xStart, 106 + i * 56, 200, 26);
+        sliders[i]->setBounds(xStart, 132 + i * 56, 200, 30);
+    }
 
-    latticeXLabel.setBounds(xStart, 180, 200, 30);
-    latticeXSlider.setBounds(xStart, 210, 200, 30);
+    droppedEventsLabel.setBounds(xStart, 610, 200, 30);
+    frameStatsLabel.setBounds(xStart, 635, 200, 30);
 
-    latticeZLabel.setBounds(xStart, 260, 200, 30);
-    latticeZSlider.setBounds(xStart, 290, 200, 30);
+    rendererLabel.setBounds(xStart, 675, 200, 30);
+    rendererMenu.setBounds(xStart, 705, 200, 30);
 
-    centsFactor3Label.setBounds(xStart, 340, 200, 30);
-    centsFactor3Slider.setBounds(xStart, 370, 200, 30);
+    scalaLabel.setBounds(xStart, 750, 200, 30);
+    loadScaleButton.setBounds(xStart, 780, 70, 26);
+    loadKeyboardMappingButton.setBounds(xStart + 72, 780, 70, 26);
+    clearScaleButton.setBounds(xStart + 144, 780, 56, 26);
+    scalaStatusLabel.setBounds(xStart, 810, 200, 50);
 
-    centsFactor5Label.setBounds(xStart, 420, 200, 30);
-    centsFactor5Slider.setBounds(xStart, 450, 200, 30);
+    instrumentationButton.setBounds(xStart, 868, 80, 26);
+    exportCountersButton.setBounds(xStart + 82, 868, 62, 26);
+    resetCountersButton.setBounds(xStart + 146, 868, 54, 26);
+    instrumentationOverlay.setBounds(latticeViewport.getX() + 8, latticeViewport.getY() + 8, 330, 150);
 
-    centsFactor7Label.setBounds(xStart, 500, 200, 30);
-    centsFactor7Slider.setBounds(xStart, 530, 200, 30);
+    timelineView.setBounds(10, 930, getWidth() - 20, 45);
 
-    toleranceLabel.setBounds(xStart, 580, 200, 30);
-    toleranceSlider.setBounds(xStart, 610, 200, 30);
+    recordLogButton.setBounds(10, 985, 120, 26);
+    openLogButton.setBounds(135, 985, 100, 26);
+    replayButton.setBounds(240, 985, 60, 26);
+    replaySpeedMenu.setBounds(305, 985, 70, 26);
+    replayPositionSlider.setBounds(380, 985, getWidth() - 390, 26);
+    eventLogStatusLabel.setBounds(10, 1015, getWidth() - 20, 26);
 }
 
 PluginEditor::~PluginEditor()
 {
     mpeInstrument.removeListener(this);
+    audioProcessor.apvts.state.removeListener(this);
 }
 
-void PluginEditor::timerCallback()
+void PluginEditor::startFrameTimer()
 {
-    const juce::ScopedLock lock(mpeNotesLock);
-    updateTiles();
-    for (const std::unique_ptr<PitchClassTile>& pitchClassTile : tiles)
+    frameTimerRunning = true;
+    frameScheduler.wake();
+}
+
+// Called by the frame scheduler once per drawn frame, and at idlePollHz while it's stopped.
+// Returns whether another frame is needed.
+bool PluginEditor::renderFrame()
+{
+    if (!frameTimerRunning)
+    {
+        if (noteEventQueue.getNumReady() == 0)
+            return false;
+        frameTimerRunning = true;
+    }
+
+    PerformanceCounters& counters = audioProcessor.getCounters();
+    // Painting happens between frames, after the repaints the previous one asked for
+    double paintMs = latticeViewport.takePaintMs();
+    if (paintMs > 0)
+        counters.paint.record(paintMs * 1000.0);
+
+    if (tuningChanged)
+        rebuildDescriptors();
+
+    counters.queueDepth.record(noteEventQueue.getNumReady());
+    processNoteEvents(getTimeSeconds());
+
+    uint32_t numDroppedEvents = noteEventQueue.getNumDropped();
+    counters.numDroppedEvents.store(numDroppedEvents);
+    if (numDroppedEvents != lastNumDroppedEvents)
+    {
+        lastNumDroppedEvents = numDroppedEvents;
+        droppedEventsLabel.setText("Dropped events: " + juce::String(numDroppedEvents), juce::dontSendNotification);
+    }
+
+    // The timeline doesn't need to keep up with every frame
+    double now = getTimeSeconds();
+    if (now - lastTimelineUpdateTime >= 0.25)
+    {
+        lastTimelineUpdateTime = now;
+        timelineView.update(audioProcessor.getHistory(), now);
+        updateEventLogControls();
+    }
+
+    double updateStartMs = juce::Time::getMillisecondCounterHiRes();
+    bool animating = updateTiles();
+    counters.updateTiles.record((juce::Time::getMillisecondCounterHiRes() - updateStartMs) * 1000.0);
+    // Keep going until the analysis of the shown pitches is in, a few microseconds away
+    if (showHarmony())
+        animating = true;
+    int numRepaintedTiles = 0;
+    if (useLatticeView)
+    {
+        numRepaintedTiles = latticeView.timerUpdate();
+    }
+    else
     {
-        pitchClassTile->timerUpdate();
+        for (const std::unique_ptr<PitchClassTile>& pitchClassTile : tiles)
+        {
+            if (pitchClassTile->timerUpdate())
+                numRepaintedTiles++;
+        }
     }
+    counters.repaintedTiles.record(numRepaintedTiles);
+    if (numRepaintedTiles > 0)
+        animating = true;
+
+    updateFrameStats();
+
+    // Nothing is fading and nothing changed: stop drawing until the next note event
+    if (!animating && noteEventQueue.getNumReady() == 0 && !hasPendingEvent)
+    {
+        frameTimerRunning = false;
+        updateFrameStats();
+        return false;
+    }
+    return true;
+}
+
+// Refreshes the frame rate readout at most twice a second, and once more when frames stop
+void PluginEditor::updateFrameStats()
+{
+    double now = getTimeSeconds();
+    bool running = frameTimerRunning;
+    if (running && now - lastFrameStatsTime < 0.5)
+        return;
+
+    PerformanceCounters& counters = audioProcessor.getCounters();
+    uint64_t numMidiMessages = counters.numMidiMessages.load();
+    // The count goes down when the counters were reset since the last readout
+    uint64_t newMessages = numMidiMessages >= lastNumMidiMessages ? numMidiMessages - lastNumMidiMessages : numMidiMessages;
+    if (now > lastFrameStatsTime)
+        counters.eventsPerSecond.store((double)newMessages / (now - lastFrameStatsTime));
+    lastNumMidiMessages = numMidiMessages;
+    lastFrameStatsTime = now;
+
+    juce::String text = running
+        ? juce::String(frameScheduler.getAchievedFps(), 1) + " fps, "
+            + juce::String(frameScheduler.getAverageWorkMs(), 1) + "/"
+            + juce::String(frameScheduler.getFrameBudgetMs(), 1) + " ms"
+        : juce::String("Idle");
+    if (frameScheduler.getNumDroppedFrames() > 0)
+        text << ", " << juce::String(frameScheduler.getNumDroppedFrames()) << " dropped";
+
+    frameStatsLabel.setText(text, juce::dontSendNotification);
+    updateInstrumentationOverlay();
+}
+
+// Durations are recorded in microseconds. The message thread's are shown in milliseconds,
+// against a frame budget of a few.
+void PluginEditor::updateInstrumentationOverlay()
+{
+    if (!instrumentationOverlay.isVisible())
+        return;
+
+    const PerformanceCounters& counters = audioProcessor.getCounters();
+    juce::StringArray lines;
+    lines.add(juce::String(counters.eventsPerSecond.load(), 1) + " MIDI events/s, "
+        + juce::String(counters.numDroppedEvents.load()) + " dropped");
+    lines.add("p50 / p99 / max");
+    lines.add(formatDistribution("Queue depth", counters.queueDepth, 1.0, 0, ""));
+    lines.add(formatDistribution("MIDI handling", counters.midiHandling, 1.0, 1, " us/block"));
+    lines.add(formatDistribution("updateTiles", counters.updateTiles, 0.001, 2, " ms"));
+    lines.add(formatDistribution("Paint", counters.paint, 0.001, 2, " ms"));
+    lines.add(formatDistribution("Repainted tiles", counters.repaintedTiles, 1.0, 0, ""));
+    lines.add(formatDistribution("Lock wait", sharedResources->getLockWait(), 1.0, 1, " us"));
+    instrumentationOverlay.setText(lines.joinIntoString("\n"), juce::dontSendNotification);
+}
+
+void PluginEditor::exportCounters()
+{
+    countersFileChooser = std::make_unique<juce::FileChooser>("Export timings", juce::File(), "*.json");
+    countersFileChooser->launchAsync(
+        juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+            | juce::FileBrowserComponent::warnAboutOverwriting,
+        [this](const juce::FileChooser& chooser)
+        {
+            juce::File file = chooser.getResult();
+            if (file == juce::File())
+                return;
+            file = file.withFileExtension("json");
+            std::string json = audioProcessor.getCounters().toJson(sharedResources->getLockWait());
+            if (!file.replaceWithText(juce::String(json)))
+                eventLogStatusLabel.setText("Couldn't write " + file.getFileName(), juce::dontSendNotification);
+        });
 }
 
 void PluginEditor::handleLogMessage(const LogMessage* logMessage)
@@ -280,122 +862,224 @@ void PluginEditor::handleLogMessage(const LogMessage* logMessage)
 
 void PluginEditor::noteAdded(juce::MPENote mpeNote)
 {
-    const juce::ScopedLock lock(mpeNotesLock);
+    pushNoteEvent(NoteEvent::Type::Added, mpeNote);
+}
 
-    Pitch pitch = Pitch::fromFreqHz(mpeNote.getFrequencyInHertz());
+void PluginEditor::notePressureChanged(juce::MPENote mpeNote)
+{
+}
 
-    heldPitches.insert(pitch);
+void PluginEditor::notePitchbendChanged(juce::MPENote mpeNote)
+{
+    pushNoteEvent(NoteEvent::Type::PitchbendChanged, mpeNote);
+}
 
-    double topIntensity = *heldPitches.rbegin() == pitch ? 1.0 : 0.0;
-    double bassIntensity = *heldPitches.begin() == pitch ? 1.0 : 0.0;
-    pitchInfos[pitch] = PitchInfo(1.0, topIntensity, bassIntensity);
+void PluginEditor::noteTimbreChanged(juce::MPENote mpeNote)
+{
+}
 
-    updateNote(mpeNote);
+void PluginEditor::noteKeyStateChanged(juce::MPENote mpeNote)
+{
 }
 
-void PluginEditor::notePressureChanged(juce::MPENote mpeNote)
+void PluginEditor::noteReleased(juce::MPENote mpeNote)
 {
-    updateNote(mpeNote);
+    pushNoteEvent(NoteEvent::Type::Released, mpeNote);
 }
 
-void PluginEditor::updateNote(const juce::MPENote& mpeNote)
+// Called on the audio thread. Must not block or allocate.
+void PluginEditor::pushNoteEvent(NoteEvent::Type type, const juce::MPENote& mpeNote)
 {
-    const juce::ScopedLock lock(mpeNotesLock);
-    mpeNotes.erase(mpeNote);
-    mpeNotes.insert(mpeNote);
+    noteEventQueue.push(makeNoteEvent(type, mpeNote, audioProcessor.getCurrentEventTiming()));
 }
 
-void PluginEditor::notePitchbendChanged(juce::MPENote mpeNote)
+// Applies the events that have been heard by timeSeconds. Events arrive roughly a block
+// ahead of their audio, so the rest wait for a later frame.
+void PluginEditor::processNoteEvents(double timeSeconds)
 {
-    const juce::ScopedLock lock(mpeNotesLock);
+    while (hasPendingEvent || noteEventQueue.pop(pendingEvent))
+    {
+        if (pendingEvent.timeSeconds > timeSeconds)
+        {
+            hasPendingEvent = true;
+            return;
+        }
+        intensityModel.applyNoteEvent(pendingEvent);
+        hasPendingEvent = false;
+    }
+}
 
-    Pitch pitch = Pitch::fromFreqHz(mpeNote.getFrequencyInHertz());
+void PluginEditor::scrubTimeChanged(std::optional<double> time)
+{
+    scrubTime = time;
+    scrubModelStale = true;
+    startFrameTimer();
+}
 
-    if (mpeNotes.find(mpeNote) != mpeNotes.end())
+void PluginEditor::toggleEventLogRecording()
+{
+    EventLogWriter& writer = audioProcessor.getEventLogWriter();
+    if (writer.isLogging())
     {
-        heldPitches.erase(Pitch::fromFreqHz(mpeNotes.find(mpeNote)->getFrequencyInHertz()));
+        writer.stop();
+        updateEventLogControls();
+        return;
     }
 
-    heldPitches.insert(pitch);
-
-    double topIntensity = *heldPitches.rbegin() == pitch ? 1.0 : 0.0;
-    double bassIntensity = *heldPitches.begin() == pitch ? 1.0 : 0.0;
-    pitchInfos[pitch] = PitchInfo(1.0, topIntensity, bassIntensity);
-    updateNote(mpeNote);
+    eventLogFileChooser = std::make_unique<juce::FileChooser>("Record event log", juce::File(), "*.mvlog");
+    eventLogFileChooser->launchAsync(
+        juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+            | juce::FileBrowserComponent::warnAboutOverwriting,
+        [this](const juce::FileChooser& chooser)
+        {
+            juce::File file = chooser.getResult();
+            if (file == juce::File())
+                return;
+            juce::String error = audioProcessor.getEventLogWriter().start(file.withFileExtension("mvlog"), getTimeSeconds());
+            updateEventLogControls();
+            if (error.isNotEmpty())
+                eventLogStatusLabel.setText(error, juce::dontSendNotification);
+        });
 }
-void PluginEditor::noteTimbreChanged(juce::MPENote mpeNote)
+
+void PluginEditor::chooseEventLogToReplay()
 {
-    updateNote(mpeNote);
+    eventLogFileChooser = std::make_unique<juce::FileChooser>("Replay event log", juce::File(), "*.mvlog");
+    eventLogFileChooser->launchAsync(
+        juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [this](const juce::FileChooser& chooser)
+        {
+            juce::File file = chooser.getResult();
+            if (file == juce::File())
+                return;
+            EventLogPlayer& player = audioProcessor.getEventLogPlayer();
+            juce::String error = player.open(file);
+            replayPositionSlider.setRange(0.0, juce::jmax(0.1, player.getLengthSeconds()), 0.1);
+            replayPositionSlider.setValue(0.0, juce::dontSendNotification);
+            updateEventLogControls();
+            if (error.isNotEmpty())
+                eventLogStatusLabel.setText(error, juce::dontSendNotification);
+        });
 }
-void PluginEditor::noteKeyStateChanged(juce::MPENote mpeNote)
+
+// Replays from the position slider at the chosen speed
+void PluginEditor::toggleReplay()
 {
-    updateNote(mpeNote);
+    EventLogPlayer& player = audioProcessor.getEventLogPlayer();
+    if (player.isPlaying())
+    {
+        player.stop();
+    }
+    else
+    {
+        int speedIndex = juce::jlimit(0, (int)replaySpeeds.size() - 1, replaySpeedMenu.getSelectedId() - 1);
+        player.play(replayPositionSlider.getValue(), replaySpeeds[(size_t)speedIndex]);
+    }
+    updateEventLogControls();
+    startFrameTimer();
 }
-void PluginEditor::noteReleased(juce::MPENote mpeNote)
+
+void PluginEditor::updateEventLogControls()
 {
-    const juce::ScopedLock lock(mpeNotesLock);
+    const EventLogWriter& writer = audioProcessor.getEventLogWriter();
+    const EventLogPlayer& player = audioProcessor.getEventLogPlayer();
 
-    Pitch pitch = Pitch::fromFreqHz(mpeNote.getFrequencyInHertz());
+    recordLogButton.setButtonText(writer.isLogging() ? "Stop recording" : "Record log...");
+    replayButton.setButtonText(player.isPlaying() ? "Stop" : "Play");
+    replayButton.setEnabled(player.isOpen());
+    if (player.isPlaying())
+        replayPositionSlider.setValue(player.getPositionSeconds(), juce::dontSendNotification);
 
-    mpeNotes.erase(mpeNote);
-    for (const auto& mpeNote : mpeNotes) {
-        Pitch mpePitch = Pitch::fromFreqHz(mpeNotes.find(mpeNote)->getFrequencyInHertz());
-        if (pitch == mpePitch) {
-            return;
-        }
+    juce::StringArray status;
+    if (writer.isLogging())
+    {
+        status.add("Recording " + juce::String((juce::int64)writer.getNumRecords()) + " events to "
+            + writer.getFile().getFileName());
+        if (writer.getNumDropped() > 0)
+            status.add(juce::String(writer.getNumDropped()) + " dropped");
     }
-
-    heldPitches.erase(pitch);
+    if (player.isOpen())
+        status.add((player.isPlaying() ? "Replaying " : "Loaded ") + player.getFile().getFileName());
+    eventLogStatusLabel.setText(status.joinIntoString(", "), juce::dontSendNotification);
 }
+
 void PluginEditor::zoneLayoutChanged()
 {
 
 }
 
-void PluginEditor::updateTiles()
+// Returns whether any intensity is still changing and needs another frame
+bool PluginEditor::updateTiles()
 {
-    Pitch maxPitch = Pitch(-9999.0);
-    Pitch minPitch = Pitch(-9999.0);
-    if (heldPitches.size() > 0)
+    bool animating = intensityModel.update(getTimeSeconds());
+
+    // A scrubbed instant is rebuilt once from the nearest snapshot before it, and then holds still
+    const IntensityModel* shownModel = &intensityModel;
+    if (scrubTime.has_value())
     {
-        maxPitch = *heldPitches.rbegin();
-        minPitch = *heldPitches.begin();
+        if (scrubModelStale)
+        {
+            audioProcessor.getHistory().reconstruct(*scrubTime, scrubModel);
+            scrubModel.update(*scrubTime);
+            scrubModelStale = false;
+        }
+        shownModel = &scrubModel;
+        animating = false;
     }
 
-    double markerIntensityChange = 0.15;
+    // Bucket pitches by pitch class once, then light only the cells matching a sounding pitch class
+    pitchClassIntensities.update(shownModel->getPitchInfos());
+    latticeIndex.update(pitchClassIntensities);
+    for (int cell : latticeIndex.getChangedCells())
+        setCellIntensity(cell);
 
-    auto it = pitchInfos.begin();
-    while (it != pitchInfos.end())
-    {
-        Pitch pitch = it->first;
-        PitchInfo& pitchInfo = it->second;
-
-        if (heldPitches.find(pitch) == heldPitches.end())
-            pitchInfo.noteIntensity = std::max(pitchInfo.noteIntensity - 0.01, 0.0);
-        else 
-            pitchInfo.noteIntensity = 1.0;
-
-        if (heldPitches.find(pitch) == heldPitches.end() || pitch != maxPitch)
-            pitchInfo.topIntensity = std::max(pitchInfo.topIntensity - markerIntensityChange, 0.0);
-        else
-            pitchInfo.topIntensity = std::min(pitchInfo.topIntensity + markerIntensityChange, 1.0);
-
-        if (heldPitches.find(pitch) == heldPitches.end() || pitch != minPitch)
-            pitchInfo.bassIntensity = std::max(pitchInfo.bassIntensity - markerIntensityChange, 0.0);
-        else
-            pitchInfo.bassIntensity = std::min(pitchInfo.bassIntensity + markerIntensityChange, 1.0);
-
-        if (pitchInfo.noteIntensity <= 0)
-            it = pitchInfos.erase(it);
-        else 
-            ++it;
-    }
+    submitHarmony(shownModel->getVoices());
+    return animating;
+}
 
-    // Update PitchClassTiles
-    for (const std::unique_ptr<PitchClassTile>& pitchClassTile : tiles)
+// Hands the held pitches to the harmony worker if they differ from the last ones it was given
+void PluginEditor::submitHarmony(const VoiceTable& voices)
+{
+    const TuningParameters tuning = descriptorTable->getTuning();
+    bool changed = !submittedTuning.has_value() || !(*submittedTuning == tuning)
+        || (int)submittedHeldPitches.size() != voices.getNumHeldPitches();
+    for (int i = 0; i < voices.getNumHeldPitches() && !changed; i++)
+        changed = submittedHeldPitches[(size_t)i] != voices.getHeldPitch(i).getKey();
+    if (!changed)
+        return;
+
+    submittedHeldPitches.clear();
+    for (int i = 0; i < voices.getNumHeldPitches(); i++)
+        submittedHeldPitches.push_back(voices.getHeldPitch(i).getKey());
+    submittedTuning = tuning;
+    submittedHarmonySequence = harmonyWorker.submit(voices, tuning);
+}
+
+// Shows the newest finished analysis. One snapshot is read per frame, so the chord name and
+// shape always describe the same held pitches. Returns whether a newer one is still pending.
+bool PluginEditor::showHarmony()
+{
+    std::shared_ptr<const HarmonyAnalysis> analysis = harmonyWorker.getLatest();
+    if (analysis != nullptr && analysis->sequence != shownHarmonySequence)
     {
-        pitchClassTile->updatePitchIntensities(pitchInfos);
+        shownHarmonySequence = analysis->sequence;
+
+        juce::String text;
+        if (!analysis->chordName.empty())
+            text = juce::String(analysis->chordName) + ": " + juce::String(analysis->shapeName);
+        else if (analysis->numPitchClasses > 0)
+            text = juce::String(analysis->numPitchClasses) + " pitch classes over " + juce::String(analysis->rootName);
+        harmonyLabel.setText(text, juce::dontSendNotification);
     }
+    return shownHarmonySequence != submittedHarmonySequence;
+}
+
+void PluginEditor::setCellIntensity(int cell)
+{
+    if (useLatticeView)
+        latticeView.setIntensity(cell, latticeIndex.getIntensity(cell));
+    else
+        tiles[cell]->setIntensity(latticeIndex.getIntensity(cell));
 }
 
 //==============================================================================
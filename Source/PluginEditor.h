@@ -14,6 +14,21 @@
 #include "Hash.h"
 #include "PitchInfo.h"
 #include "InputLabel.h"
+#include "NoteEventQueue.h"
+#include "IntensityModel.h"
+#include "PitchClassIntensities.h"
+#include "LatticeIndex.h"
+#include "DescriptorTable.h"
+#include "TuningPresets.h"
+#include "LatticeView.h"
+#include "LatticeViewport.h"
+#include "LatticeProjection.h"
+#include "SharedResources.h"
+#include "FrameScheduler.h"
+#include "HarmonyWorker.h"
+#include "TimelineView.h"
+#include "ScalaMapping.h"
+#include "ScalaScale.h"
 
 class LogMessage;
 
@@ -23,8 +38,8 @@ class LogMessage;
 class PluginEditor  :
     public juce::AudioProcessorEditor, 
     public juce::MPEInstrument::Listener,
-    public juce::Timer,
-    private juce::Slider::Listener
+    private juce::Slider::Listener,
+    private juce::ValueTree::Listener
 {
 public:
     PluginEditor (PluginProcessor&, juce::MPEInstrument&);
@@ -45,11 +60,39 @@ public:
     void noteReleased(juce::MPENote) override;
     void zoneLayoutChanged() override;
 
-    void updateTiles();
-    void timerCallback();
+    bool updateTiles();
 private:
+    bool renderFrame();
+    void updateFrameStats();
+    void updateInstrumentationOverlay();
+    void exportCounters();
+    void scrubTimeChanged(std::optional<double>);
+    void toggleEventLogRecording();
+    void chooseEventLogToReplay();
+    void toggleReplay();
+    void updateEventLogControls();
+    void startFrameTimer();
+    void rendererChanged();
+    void projectionChanged();
+    void rebuildCells();
+    void panLattice(int horizontalDelta, int verticalDelta);
+    int getLatticeOffset(LatticeAxis) const;
+    void setLatticeOffset(const char* parameterID, int);
+    void rebuildDescriptors(bool newCells = false);
+    void tuningPresetChanged();
+    void updateTuningMenu();
+    void chooseScalaFile(bool keyboardMapping);
+    void setScalaFiles(const juce::String& scl, const juce::String& kbm);
+    void loadScalaFromState();
+    void updateScalaMapping();
+    void updateScalaLabel();
+    void valueTreeRedirected(juce::ValueTree&) override;
+    void setCellIntensity(int);
+    void submitHarmony(const VoiceTable&);
+    bool showHarmony();
     void handleLogMessage(const LogMessage*);
-    void updateNote(const juce::MPENote&);
+    void pushNoteEvent(NoteEvent::Type, const juce::MPENote&);
+    void processNoteEvents(double);
     void initInputLabel(juce::Label&);
 
     // This reference is provided as a quick way for your editor to
@@ -61,23 +104,109 @@ private:
     std::vector<juce::String> logMessages;
     juce::TextEditor logBox;
 
+    // Label images and descriptor tables, shared with every other editor in the process
+    juce::SharedResourcePointer<SharedResources> sharedResources;
+    // Holds the cells overlapping it at its tile size, rebuilt when it zooms
+    LatticeViewport latticeViewport;
     std::vector<std::unique_ptr<PitchClassTile>> tiles;
-
-    juce::CriticalSection mpeNotesLock;
-    std::unordered_set<juce::MPENote, MPENoteHash> mpeNotes;
-    std::map<Pitch, PitchInfo> pitchInfos;
-    std::set<Pitch> heldPitches;
+    LatticeView latticeView;
+    bool useLatticeView;
+
+    // Written by the MPEInstrument listener callbacks on the audio thread,
+    // drained on the message thread once per frame
+    NoteEventQueue noteEventQueue;
+    uint32_t lastNumDroppedEvents;
+    // First event popped that isn't audible yet. Applied on the first frame at or after its time.
+    NoteEvent pendingEvent;
+    bool hasPendingEvent;
+
+    // False while the frame scheduler is stopped because nothing is animating. Only a slow
+    // timer at idlePollHz runs meanwhile, and the first tick that finds a note event queued
+    // starts frames again, so the audio thread never has to post to the message thread.
+    bool frameTimerRunning;
+    FrameScheduler frameScheduler;
+    double lastFrameStatsTime;
+
+    // Only accessed on the message thread
+    IntensityModel intensityModel;
+    // Past state rebuilt from the processor's history while the timeline is scrubbed.
+    // Live events keep going into intensityModel meanwhile.
+    std::optional<double> scrubTime;
+    IntensityModel scrubModel;
+    bool scrubModelStale;
+    PitchClassIntensities pitchClassIntensities;
+    // Lattice coordinates of each cell before the offset sliders, in the same order as tiles
+    std::vector<LatticeCoordinates> cellBases;
+    LatticeIndex latticeIndex;
+
+    // Latest tuning from the sliders, built into descriptorTable on the next frame
+    TuningParameters pendingTuning;
+    bool tuningChanged;
+    // Descriptors currently shown. Replaced as a whole, never modified in place.
+    // Only read and swapped on the message thread.
+    std::shared_ptr<const DescriptorTable> descriptorTable;
+
+    // Imported Scala scale, empty when the lattice follows the interval sliders alone.
+    // scalaMapping is re-solved when the intervals change, or restored from the saved state.
+    ScalaScale scalaScale;
+    ScalaMapping scalaMapping;
+    juce::String scalaError;
+    std::unique_ptr<juce::FileChooser> scalaFileChooser;
+
+    // Chord analysis of the shown held pitches, resubmitted when they or the tuning change
+    HarmonyWorker harmonyWorker;
+    std::vector<int32_t> submittedHeldPitches;
+    std::optional<TuningParameters> submittedTuning;
+    uint64_t submittedHarmonySequence;
+    uint64_t shownHarmonySequence;
 
     juce::MPEInstrument& mpeInstrument;
 
+    juce::Label harmonyLabel;
     juce::ComboBox tuningMenu;
+    juce::ComboBox projectionMenu;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> projectionAttachment;
+
+    juce::Label droppedEventsLabel;
+    juce::Label frameStatsLabel;
+
+    // Timings from the processor's counters, drawn over the lattice when switched on. They're
+    // collected either way, so the overlay and the export only read them.
+    juce::Label instrumentationOverlay;
+    juce::ToggleButton instrumentationButton;
+    juce::TextButton exportCountersButton;
+    juce::TextButton resetCountersButton;
+    std::unique_ptr<juce::FileChooser> countersFileChooser;
+    uint64_t lastNumMidiMessages;
+
+    juce::Label rendererLabel;
+    juce::ComboBox rendererMenu;
+
+    juce::Label scalaLabel;
+    juce::TextButton loadScaleButton;
+    juce::TextButton loadKeyboardMappingButton;
+    juce::TextButton clearScaleButton;
+    juce::Label scalaStatusLabel;
+
+    TimelineView timelineView;
+    double lastTimelineUpdateTime;
+
+    juce::TextButton recordLogButton;
+    juce::TextButton openLogButton;
+    juce::TextButton replayButton;
+    juce::ComboBox replaySpeedMenu;
+    juce::Slider replayPositionSlider;
+    juce::Label eventLogStatusLabel;
+    std::unique_ptr<juce::FileChooser> eventLogFileChooser;
 
     juce::Label latticeXLabel;
     juce::Label latticeYLabel;
     juce::Label latticeZLabel;
+    juce::Label latticeWLabel;
     juce::Label centsFactor3Label;
     juce::Label centsFactor5Label;
     juce::Label centsFactor7Label;
+    juce::Label centsFactor11Label;
     juce::Label toleranceLabel;
 
     juce::Label factor3ToFactor5Label;
@@ -86,18 +215,26 @@ private:
     juce::Slider latticeXSlider;
     juce::Slider latticeYSlider;
     juce::Slider latticeZSlider;
+    juce::Slider latticeWSlider;
     juce::Slider centsFactor3Slider;
     juce::Slider centsFactor5Slider;
     juce::Slider centsFactor7Slider;
+    juce::Slider centsFactor11Slider;
     juce::Slider toleranceSlider;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> latticeXAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> latticeYAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> latticeZAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> latticeWAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> centsFactor3Attachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> centsFactor5Attachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> centsFactor7Attachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> centsFactor11Attachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> toleranceAttachment;
 
+    // Never shown. They follow the legacy offset parameters, which hosts may still automate.
+    std::array<juce::Slider, 3> legacyOffsetSliders;
+    std::array<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>, 3> legacyOffsetAttachments;
+
     virtual void sliderValueChanged(juce::Slider* slider) override;
 };
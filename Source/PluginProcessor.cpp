@@ -11,6 +11,14 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 #include "LogMessage.h"
+#include "MPENoteEvents.h"
+#include "LatticeProjection.h"
+#include "ScalaState.h"
+
+namespace {
+// A chunk of the history lasts about a minute at 1000 events per second, so this stays well ahead
+const int historyGrowIntervalMs = 1000;
+}
 
 //==============================================================================
 PluginProcessor::PluginProcessor()
@@ -24,13 +32,18 @@ PluginProcessor::PluginProcessor()
                      #endif
                        ), apvts(*this, nullptr, "Parameters", createParameters())
 #endif
+     , currentSamplePosition(0)
+     , history(getTimeSeconds())
+     , eventLogPlayer(replayCollector)
 {
     mpeInstrument.enableLegacyMode(24);
-
+    mpeInstrument.addListener(this);
+    startTimer(historyGrowIntervalMs);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParameters()
 {
+    // In the order they were added, so hosts that save automation by index keep finding them
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         "CENTS_FACTOR_3", "P5 cents", 680.f, 720.f, 700.f));
@@ -40,17 +53,37 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         "CENTS_FACTOR_7", "H7 cents", 960.f, 1000.f, 1000.f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>(
         "CENTS_TOLERANCE", "Tolerance", 1.0f, 50.f, 0.1f));
+    // The offsets from before the lattice grew past 10 steps, unchanged so that saved sessions
+    // and automation still mean the same. The editor adds them to the LATTICE_FACTOR_ offsets.
     params.push_back(std::make_unique<juce::AudioParameterInt>(
         "LATTICE_X", "X offset", -10, 10, 0));
     params.push_back(std::make_unique<juce::AudioParameterInt>(
         "LATTICE_Y", "Y offset", -10, 10, 0));
     params.push_back(std::make_unique<juce::AudioParameterInt>(
         "LATTICE_Z", "Z offset", -10, 10, 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        "CENTS_FACTOR_11", "11/8 cents", 500.f, 600.f, 600.f));
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "LATTICE_W", "11/8 offset", -DescriptorTable::maxFactor11, DescriptorTable::maxFactor11, 0));
+
+    juce::StringArray projectionNames;
+    for (const LatticeProjection& projection : LatticeProjections::projections)
+        projectionNames.add(projection.name);
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        "PROJECTION", "Projection", projectionNames, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "LATTICE_FACTOR_3", "P5 offset", -DescriptorTable::maxFactor3, DescriptorTable::maxFactor3, 0));
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "LATTICE_FACTOR_5", "M3 offset", -DescriptorTable::maxFactor5, DescriptorTable::maxFactor5, 0));
+    params.push_back(std::make_unique<juce::AudioParameterInt>(
+        "LATTICE_FACTOR_7", "H7 offset", -DescriptorTable::maxFactor7, DescriptorTable::maxFactor7, 0));
     return { params.begin(), params.end() };
 }
 
 PluginProcessor::~PluginProcessor()
 {
+    mpeInstrument.removeListener(this);
 }
 
 //==============================================================================
@@ -118,8 +151,9 @@ void PluginProcessor::changeProgramName (int index, const juce::String& newName)
 //==============================================================================
 void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Use this method as the place to do any pre-playback
-    // initialisation that you need..
+    blockClock.prepare(sampleRate);
+    replayCollector.reset(sampleRate);
+    replayMessages.ensureSize(4096);
 }
 
 void PluginProcessor::releaseResources()
@@ -161,12 +195,95 @@ PluginEditor* PluginProcessor::getEditor() const noexcept
 
 void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    // The host's callback timestamp is steadier than reading the clock here, when it has one
+    double hostTimeSeconds = -1.0;
+   #if JUCE_MAJOR_VERSION >= 7
+    if (juce::AudioPlayHead* playHead = getPlayHead())
+        if (juce::Optional<juce::AudioPlayHead::PositionInfo> position = playHead->getPosition())
+            if (juce::Optional<juce::uint64> hostTimeNs = position->getHostTimeNs())
+                hostTimeSeconds = (double)*hostTimeNs * 1.0e-9;
+   #endif
+
+    blockClock.beginBlock(getTimeSeconds(), hostTimeSeconds, buffer.getNumSamples(), getLatencySamples());
+
+    const juce::int64 handlingStartTicks = juce::Time::getHighResolutionTicks();
+    int numMessages = 0;
     for (const juce::MidiBufferIterator::reference metadata : midiMessages)
     {
+        currentSamplePosition = metadata.samplePosition;
+        juce::MidiMessage message = metadata.getMessage();
+        eventLogWriter.push(message, getCurrentEventTiming().timeSeconds);
+        handleMessage(message);
+        numMessages++;
+    }
+
+    // Replayed messages go through the same instrument but aren't logged again.
+    // The collector has to be drained every block to keep its timing in step.
+    replayMessages.clear();
+    replayCollector.removeNextBlockOfMessages(replayMessages, buffer.getNumSamples());
+    for (const juce::MidiBufferIterator::reference metadata : replayMessages)
+    {
+        currentSamplePosition = metadata.samplePosition;
         handleMessage(metadata.getMessage());
+        numMessages++;
+    }
+    currentSamplePosition = 0;
+
+    // Blocks without MIDI would only bury the ones that matter
+    if (numMessages > 0)
+    {
+        counters.numMidiMessages.fetch_add((uint64_t)numMessages, std::memory_order_relaxed);
+        counters.midiHandling.record(juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - handlingStartTicks) * 1.0e6);
     }
 }
 
+EventTiming PluginProcessor::getCurrentEventTiming() const
+{
+    return blockClock.getEventTiming(currentSamplePosition);
+}
+
+const PerformanceHistory& PluginProcessor::getHistory() const
+{
+    return history;
+}
+
+PerformanceCounters& PluginProcessor::getCounters()
+{
+    return counters;
+}
+
+EventLogWriter& PluginProcessor::getEventLogWriter()
+{
+    return eventLogWriter;
+}
+
+EventLogPlayer& PluginProcessor::getEventLogPlayer()
+{
+    return eventLogPlayer;
+}
+
+// MPEInstrument callbacks, on the audio thread
+void PluginProcessor::noteAdded(juce::MPENote mpeNote)
+{
+    history.record(makeNoteEvent(NoteEvent::Type::Added, mpeNote, getCurrentEventTiming()));
+}
+
+void PluginProcessor::notePitchbendChanged(juce::MPENote mpeNote)
+{
+    history.record(makeNoteEvent(NoteEvent::Type::PitchbendChanged, mpeNote, getCurrentEventTiming()));
+}
+
+void PluginProcessor::noteReleased(juce::MPENote mpeNote)
+{
+    history.record(makeNoteEvent(NoteEvent::Type::Released, mpeNote, getCurrentEventTiming()));
+}
+
+void PluginProcessor::timerCallback()
+{
+    history.grow();
+}
+
 void PluginProcessor::handleMessage(const juce::MidiMessage& message) 
 {
     /*
@@ -246,11 +363,32 @@ void PluginProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
+    // The parameter state also carries the imported Scala scale and its solved mapping,
+    // see ScalaState.
     auto state = apvts.copyState();
+    storeScalaMapping(state);
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
 }
 
+// The editor keeps the mappings it solves in memory, so dragging an interval slider doesn't
+// write to the parameter state and mark the project as changed. The saved copy gets the
+// mapping for the current intervals instead, so restoring it doesn't have to solve again.
+void PluginProcessor::storeScalaMapping(juce::ValueTree& state) const
+{
+    juce::ValueTree scalaState = ScalaState::get(state);
+    ScalaScale scale;
+    if (ScalaState::loadScale(scalaState, scale).isNotEmpty() || scale.isEmpty())
+        return;
+
+    double s3 = apvts.getRawParameterValue("CENTS_FACTOR_3")->load() * 0.01;
+    double s5 = apvts.getRawParameterValue("CENTS_FACTOR_5")->load() * 0.01;
+    double s7 = apvts.getRawParameterValue("CENTS_FACTOR_7")->load() * 0.01;
+    std::optional<ScalaMapping> stored = ScalaState::loadMapping(scalaState);
+    if (!stored.has_value() || !stored->isSolvedFor(scale.getHash(), s3, s5, s7))
+        ScalaState::storeMapping(scalaState, ScalaMapping::solve(scale, s3, s5, s7));
+}
+
 void PluginProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
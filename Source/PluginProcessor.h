@@ -9,13 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "BlockClock.h"
+#include "EventLogPlayer.h"
+#include "EventLogWriter.h"
+#include "PerformanceCounters.h"
+#include "PerformanceHistory.h"
 
 class PluginEditor;
 
 //==============================================================================
 /**
 */
-class PluginProcessor  : public juce::AudioProcessor
+class PluginProcessor  : public juce::AudioProcessor,
+                         private juce::MPEInstrument::Listener,
+                         private juce::Timer
 {
 public:
     //==============================================================================
@@ -57,15 +64,51 @@ public:
 
     juce::AudioProcessorValueTreeState apvts;
 
+    // When the MIDI message currently being handled is heard. Audio thread only,
+    // meant for MPEInstrument listeners called from within processBlock.
+    EventTiming getCurrentEventTiming() const;
+
+    // Everything played since the plugin was loaded, recorded whether or not the editor is open
+    const PerformanceHistory& getHistory() const;
+
+    // Timings of this instance, collected whether or not the editor is open. The editor
+    // records the message thread's share of them.
+    PerformanceCounters& getCounters();
+
+    // Session log of the MIDI input on disk, and replay of one through the same pipeline.
+    // Message thread only.
+    EventLogWriter& getEventLogWriter();
+    EventLogPlayer& getEventLogPlayer();
+
 private:
     PluginEditor* getEditor() const noexcept;
 
     void handleMessage(const juce::MidiMessage&);
+    void storeScalaMapping(juce::ValueTree& state) const;
+
+    void noteAdded(juce::MPENote) override;
+    void notePitchbendChanged(juce::MPENote) override;
+    void noteReleased(juce::MPENote) override;
+
+    // Grows the history ahead of the audio thread, which can't allocate
+    void timerCallback() override;
 
     static juce::String getMidiMessageDescription(const juce::MidiMessage&);
 
     juce::MPEInstrument mpeInstrument;
 
+    BlockClock blockClock;
+    int currentSamplePosition;
+
+    PerformanceHistory history;
+    PerformanceCounters counters;
+
+    EventLogWriter eventLogWriter;
+    // Filled by the player's thread, drained at the start of every block
+    juce::MidiMessageCollector replayCollector;
+    juce::MidiBuffer replayMessages;
+    EventLogPlayer eventLogPlayer;
+
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
     juce::AudioParameterFloat* centsFactor3;
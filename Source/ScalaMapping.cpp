@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ScalaMapping.h"
+#include "Pitch.h"
+
+namespace {
+// Every step away from C costs this much, so a simple lattice position wins over a complex one
+// that's only slightly closer. Thirds and sevenths count as two and three steps.
+const double complexityPenaltyCents = 0.5;
+// Interval sizes that differ by less than this, in semitones, are the same tuning. Cached
+// mappings come back from text, which needn't round trip doubles exactly.
+const double tuningEpsilon = 1e-9;
+}
+
+ScalaMapping::ScalaMapping() : scaleHash(0), semisFactor3(0), semisFactor5(0), semisFactor7(0)
+{
+}
+
+ScalaMapping::ScalaMapping(uint64_t scaleHash, double semisFactor3, double semisFactor5, double semisFactor7,
+	std::vector<ScaleDegreeMapping> degrees) :
+	scaleHash(scaleHash),
+	semisFactor3(semisFactor3),
+	semisFactor5(semisFactor5),
+	semisFactor7(semisFactor7),
+	degrees(std::move(degrees))
+{
+	buildIndex();
+}
+
+ScalaMapping ScalaMapping::solve(const ScalaScale& scale, double semisFactor3, double semisFactor5, double semisFactor7)
+{
+	// Pitch class keys of every lattice position in range, computed once for all degrees
+	struct Candidate
+	{
+		int32_t key;
+		LatticeCoordinates coordinates;
+		double complexity;
+	};
+	std::vector<Candidate> candidates;
+	for (int factor3 = -maxFactor3; factor3 <= maxFactor3; factor3++)
+	{
+		for (int factor5 = -maxFactor5; factor5 <= maxFactor5; factor5++)
+		{
+			for (int factor7 = -maxFactor7; factor7 <= maxFactor7; factor7++)
+			{
+				const PitchClass pitchClass(Pitch(semisFactor3 * factor3 + semisFactor5 * factor5 + semisFactor7 * factor7));
+				candidates.push_back(Candidate{ pitchClass.getKey(), { factor3, factor5, factor7 },
+					(double)(std::abs(factor3) + 2 * std::abs(factor5) + 3 * std::abs(factor7)) });
+			}
+		}
+	}
+
+	std::vector<ScaleDegreeMapping> degrees;
+	for (int degree = 0; degree < scale.getNumDegrees(); degree++)
+	{
+		const int32_t key = scale.getPitchClass(degree).getKey();
+		const Candidate* best = nullptr;
+		double bestScore = 0;
+		for (const Candidate& candidate : candidates)
+		{
+			const double errorCents = PitchClass::distance(key, candidate.key) * 0.001;
+			const double score = errorCents + candidate.complexity * complexityPenaltyCents;
+			if (best == nullptr || score < bestScore)
+			{
+				best = &candidate;
+				bestScore = score;
+			}
+		}
+
+		const double errorCents = PitchClass::distance(key, best->key) * 0.001;
+		degrees.push_back(ScaleDegreeMapping{ degree, key, best->coordinates, errorCents });
+	}
+
+	return ScalaMapping(scale.getHash(), semisFactor3, semisFactor5, semisFactor7, std::move(degrees));
+}
+
+bool ScalaMapping::isEmpty() const
+{
+	return degrees.empty();
+}
+
+bool ScalaMapping::isSolvedFor(uint64_t hash, double s3, double s5, double s7) const
+{
+	return hash == scaleHash && std::abs(s3 - semisFactor3) < tuningEpsilon
+		&& std::abs(s5 - semisFactor5) < tuningEpsilon && std::abs(s7 - semisFactor7) < tuningEpsilon;
+}
+
+uint64_t ScalaMapping::getScaleHash() const
+{
+	return scaleHash;
+}
+
+double ScalaMapping::getSemisFactor3() const
+{
+	return semisFactor3;
+}
+
+double ScalaMapping::getSemisFactor5() const
+{
+	return semisFactor5;
+}
+
+double ScalaMapping::getSemisFactor7() const
+{
+	return semisFactor7;
+}
+
+const std::vector<ScaleDegreeMapping>& ScalaMapping::getDegrees() const
+{
+	return degrees;
+}
+
+uint64_t ScalaMapping::packCoordinates(const LatticeCoordinates& c)
+{
+	return (uint64_t)(uint32_t)c.factor3 << 32 | (uint64_t)(uint16_t)c.factor5 << 16 | (uint16_t)c.factor7;
+}
+
+void ScalaMapping::buildIndex()
+{
+	index.clear();
+	for (int i = 0; i < (int)degrees.size(); i++)
+		index.emplace_back(packCoordinates(degrees[i].coordinates), i);
+	std::sort(index.begin(), index.end());
+}
+
+int ScalaMapping::find(const LatticeCoordinates& coordinates) const
+{
+	// Degrees are placed in the 7-limit, so only on the eleventh axis' zero slice
+	if (coordinates.factor11 != 0)
+		return -1;
+	const uint64_t packed = packCoordinates(coordinates);
+	auto it = std::lower_bound(index.begin(), index.end(), std::make_pair(packed, -1));
+	if (it == index.end() || it->first != packed)
+		return -1;
+	return it->second;
+}
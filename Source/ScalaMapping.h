@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "ScalaScale.h"
+
+// Where a scale degree sits on the lattice
+struct ScaleDegreeMapping
+{
+	int degree;
+	int32_t pitchClassKey;
+	// Closest lattice position under the tuning the mapping was solved for
+	LatticeCoordinates coordinates;
+	// How far the lattice position's pitch class is from the degree's
+	double errorCents;
+};
+
+// Every degree of a ScalaScale mapped to its nearest lattice coordinates.
+// Solving depends on the scale and the fifth, third and seventh sizes, so a solved mapping is
+// kept (and persisted) with those and only re-solved when one of them changes.
+class ScalaMapping
+{
+public:
+	// Search range of the solver, in steps of each interval from C
+	static constexpr int maxFactor3 = 12;
+	static constexpr int maxFactor5 = 4;
+	static constexpr int maxFactor7 = 1;
+
+	ScalaMapping();
+	// Restores a previously solved mapping
+	ScalaMapping(uint64_t scaleHash, double semisFactor3, double semisFactor5, double semisFactor7,
+		std::vector<ScaleDegreeMapping>);
+	static ScalaMapping solve(const ScalaScale&, double semisFactor3, double semisFactor5, double semisFactor7);
+
+	bool isEmpty() const;
+	bool isSolvedFor(uint64_t scaleHash, double semisFactor3, double semisFactor5, double semisFactor7) const;
+	uint64_t getScaleHash() const;
+	double getSemisFactor3() const;
+	double getSemisFactor5() const;
+	double getSemisFactor7() const;
+	const std::vector<ScaleDegreeMapping>& getDegrees() const;
+	// Index into getDegrees() of the degree placed at the coordinates, or -1. When several
+	// degrees share a position the lowest one wins.
+	int find(const LatticeCoordinates&) const;
+private:
+	static uint64_t packCoordinates(const LatticeCoordinates&);
+	void buildIndex();
+
+	uint64_t scaleHash;
+	double semisFactor3;
+	double semisFactor5;
+	double semisFactor7;
+	std::vector<ScaleDegreeMapping> degrees;
+	// Packed coordinates and index into degrees, sorted
+	std::vector<std::pair<uint64_t, int>> index;
+};
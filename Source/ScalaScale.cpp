@@ -0,0 +1,261 @@
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include "ScalaScale.h"
+#include "Pitch.h"
+
+namespace {
+const double middleC = 60.0;
+// One entry per MIDI key. Longer maps couldn't be reached by any note.
+const int maxMapSize = 128;
+
+// Lines that aren't comments, with surrounding whitespace removed
+std::vector<std::string> getLines(const std::string& text)
+{
+	std::vector<std::string> lines;
+	std::istringstream stream(text);
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		if (!line.empty() && line[0] == '!')
+			continue;
+		const size_t begin = line.find_first_not_of(" \t\r");
+		const size_t end = line.find_last_not_of(" \t\r");
+		lines.push_back(begin == std::string::npos ? std::string() : line.substr(begin, end - begin + 1));
+	}
+	return lines;
+}
+
+std::string getFirstToken(const std::string& line)
+{
+	const size_t end = line.find_first_of(" \t");
+	return end == std::string::npos ? line : line.substr(0, end);
+}
+
+// Fails on numbers outside the range of int rather than wrapping them
+bool parseInt(const std::string& text, int& value)
+{
+	char* end = nullptr;
+	errno = 0;
+	const long long parsed = std::strtoll(text.c_str(), &end, 10);
+	if (end == text.c_str() || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX)
+		return false;
+	value = (int)parsed;
+	return true;
+}
+
+// Ratio terms are whole numbers of any length, like the long numerators of Pythagorean
+// intervals, so they're read as doubles. Those past the double range come back as infinity.
+bool parseRatioTerm(const std::string& text, double& value)
+{
+	if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	value = std::strtod(text.c_str(), nullptr);
+	return true;
+}
+
+bool parseDouble(const std::string& text, double& value)
+{
+	char* end = nullptr;
+	value = std::strtod(text.c_str(), &end);
+	return end != text.c_str() && *end == '\0';
+}
+
+// A pitch line is cents if it contains a period, otherwise a ratio or whole number.
+// Returns an empty string on success, otherwise a description of the problem.
+std::string parsePitch(const std::string& line, double& semitones)
+{
+	const std::string token = getFirstToken(line);
+	if (token.find('.') != std::string::npos)
+	{
+		double cents;
+		if (!parseDouble(token, cents) || !std::isfinite(cents))
+			return "Can't read the pitch on line \"" + line + "\"";
+		semitones = cents * 0.01;
+		return {};
+	}
+
+	double numerator = 0;
+	double denominator = 1;
+	const size_t slash = token.find('/');
+	if (!parseRatioTerm(token.substr(0, slash), numerator)
+		|| (slash != std::string::npos && !parseRatioTerm(token.substr(slash + 1), denominator)))
+		return "Can't read the pitch on line \"" + line + "\"";
+	if (std::isinf(numerator) || std::isinf(denominator))
+		return "The ratio on line \"" + line + "\" is too large";
+	if (numerator <= 0 || denominator <= 0)
+		return "Can't read the pitch on line \"" + line + "\"";
+	semitones = 12.0 * std::log2(numerator / denominator);
+	return {};
+}
+
+int floorDiv(int a, int b)
+{
+	return a / b - (a % b != 0 && (a < 0) != (b < 0) ? 1 : 0);
+}
+
+int floorMod(int a, int b)
+{
+	return a - floorDiv(a, b) * b;
+}
+}
+
+ScalaScale::ScalaScale() : period(12.0), rootMidiPitch(middleC)
+{
+}
+
+std::string ScalaScale::parseScale(const std::string& sclText)
+{
+	const std::vector<std::string> lines = getLines(sclText);
+	if (lines.size() < 2)
+		return "The scale file has no note count";
+
+	int numNotes;
+	if (!parseInt(getFirstToken(lines[1]), numNotes) || numNotes <= 0)
+		return "The note count isn't a positive number";
+	if (numNotes > (int)lines.size() - 2)
+		return "The scale file lists fewer notes than its note count";
+
+	std::vector<double> pitches;
+	for (int i = 0; i < numNotes; i++)
+	{
+		double semitones = 0.0;
+		const std::string error = parsePitch(lines[2 + i], semitones);
+		if (!error.empty())
+			return error;
+		pitches.push_back(semitones);
+	}
+
+	if (pitches.back() <= 0)
+		return "The scale's period isn't above its root";
+
+	description = lines[0];
+	period = pitches.back();
+	degrees.assign(1, 0.0);
+	degrees.insert(degrees.end(), pitches.begin(), pitches.end() - 1);
+	return {};
+}
+
+std::string ScalaScale::parseKeyboardMapping(const std::string& kbmText)
+{
+	if (isEmpty())
+		return "Load a scale before its keyboard mapping";
+
+	const std::vector<std::string> lines = getLines(kbmText);
+	if (lines.size() < 7)
+		return "The keyboard mapping is missing header lines";
+
+	int mapSize, firstNote, lastNote, middleNote, referenceNote, formalOctave;
+	double referenceFrequency;
+	if (!parseInt(getFirstToken(lines[0]), mapSize) || mapSize < 0
+		|| !parseInt(getFirstToken(lines[1]), firstNote)
+		|| !parseInt(getFirstToken(lines[2]), lastNote)
+		|| !parseInt(getFirstToken(lines[3]), middleNote)
+		|| !parseInt(getFirstToken(lines[4]), referenceNote)
+		|| !parseDouble(getFirstToken(lines[5]), referenceFrequency) || referenceFrequency <= 0
+		|| !parseInt(getFirstToken(lines[6]), formalOctave))
+		return "Can't read the keyboard mapping's header";
+	if (mapSize > maxMapSize)
+		return "The keyboard mapping has more than " + std::to_string(maxMapSize) + " entries";
+
+	std::vector<int> mapping;
+	for (int i = 0; i < mapSize; i++)
+	{
+		int degree = -1;
+		const std::string token = 7 + i < (int)lines.size() ? getFirstToken(lines[7 + i]) : "x";
+		if (token != "x" && !parseInt(token, degree))
+			return "Can't read the keyboard mapping entry \"" + token + "\"";
+		mapping.push_back(degree);
+	}
+
+	// Find which degree the reference note plays, then put the root where that makes it sound
+	// at the reference frequency
+	const int steps = referenceNote - middleNote;
+	double semitonesAboveRoot;
+	if (mapSize == 0)
+	{
+		semitonesAboveRoot = getExtendedDegree(steps);
+	}
+	else
+	{
+		const int degree = mapping[floorMod(steps, mapSize)];
+		if (degree < 0)
+			return "The reference note isn't mapped to a scale degree";
+		const double formalOctaveSemitones = formalOctave == 0 ? period : getExtendedDegree(formalOctave);
+		semitonesAboveRoot = floorDiv(steps, mapSize) * formalOctaveSemitones + getExtendedDegree(degree);
+	}
+
+	rootMidiPitch = Pitch::fromFreqHz(referenceFrequency).getMidiPitch() - semitonesAboveRoot;
+	return {};
+}
+
+void ScalaScale::clear()
+{
+	description.clear();
+	degrees.clear();
+	period = 12.0;
+	rootMidiPitch = middleC;
+}
+
+double ScalaScale::getExtendedDegree(int degree) const
+{
+	const int numDegrees = getNumDegrees();
+	return floorDiv(degree, numDegrees) * period + degrees[floorMod(degree, numDegrees)];
+}
+
+bool ScalaScale::isEmpty() const
+{
+	return degrees.empty();
+}
+
+const std::string& ScalaScale::getDescription() const
+{
+	return description;
+}
+
+int ScalaScale::getNumDegrees() const
+{
+	return (int)degrees.size();
+}
+
+double ScalaScale::getDegree(int degree) const
+{
+	return degrees[degree];
+}
+
+double ScalaScale::getPeriod() const
+{
+	return period;
+}
+
+double ScalaScale::getRootMidiPitch() const
+{
+	return rootMidiPitch;
+}
+
+PitchClass ScalaScale::getPitchClass(int degree) const
+{
+	return PitchClass(Pitch(rootMidiPitch + degrees[degree]));
+}
+
+uint64_t ScalaScale::getHash() const
+{
+	if (isEmpty())
+		return 0;
+
+	// FNV-1a over the degrees' pitch class keys
+	uint64_t hash = 14695981039346656037ull;
+	for (int degree = 0; degree < getNumDegrees(); degree++)
+	{
+		uint32_t key = (uint32_t)getPitchClass(degree).getKey();
+		for (int byte = 0; byte < 4; byte++)
+		{
+			hash ^= (key >> (byte * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PitchClass.h"
+
+// A Scala scale (.scl) with an optional keyboard mapping (.kbm), reduced to what the lattice
+// needs: where the scale is rooted and the pitch of every degree above the root.
+// See https://www.huygens-fokker.org/scala/scl_format.html
+class ScalaScale
+{
+public:
+	ScalaScale();
+	// Both return an empty string on success, otherwise a description of the problem.
+	// On failure the scale is left unchanged.
+	std::string parseScale(const std::string& sclText);
+	// Without a keyboard mapping the root is middle C
+	std::string parseKeyboardMapping(const std::string& kbmText);
+	void clear();
+
+	bool isEmpty() const;
+	const std::string& getDescription() const;
+	int getNumDegrees() const;
+	// Semitones above the root. Degree 0 is the root itself, the period isn't included.
+	double getDegree(int) const;
+	// Interval the scale repeats at, usually the octave
+	double getPeriod() const;
+	double getRootMidiPitch() const;
+	// Pitch class of a degree, with the root applied
+	PitchClass getPitchClass(int degree) const;
+	// Identifies the pitch classes of the scale, 0 when empty
+	uint64_t getHash() const;
+private:
+	// Semitones above the root of a degree that can lie outside the first period
+	double getExtendedDegree(int) const;
+
+	std::string description;
+	std::vector<double> degrees;
+	double period;
+	double rootMidiPitch;
+};
@@ -0,0 +1,109 @@
+#include "ScalaState.h"
+
+namespace {
+const juce::Identifier scalaType("SCALA");
+const juce::Identifier mappingType("MAPPING");
+const juce::Identifier degreeType("DEGREE");
+const juce::Identifier sclId("scl");
+const juce::Identifier kbmId("kbm");
+const juce::Identifier scaleHashId("scaleHash");
+const juce::Identifier semisFactor3Id("semisFactor3");
+const juce::Identifier semisFactor5Id("semisFactor5");
+const juce::Identifier semisFactor7Id("semisFactor7");
+const juce::Identifier degreeId("degree");
+const juce::Identifier keyId("key");
+const juce::Identifier factor3Id("factor3");
+const juce::Identifier factor5Id("factor5");
+const juce::Identifier factor7Id("factor7");
+const juce::Identifier errorId("error");
+}
+
+juce::ValueTree ScalaState::get(juce::ValueTree& parameterState)
+{
+	return parameterState.getOrCreateChildWithName(scalaType, nullptr);
+}
+
+void ScalaState::setFiles(juce::ValueTree& scalaState, const juce::String& scl, const juce::String& kbm)
+{
+	scalaState.setProperty(sclId, scl, nullptr);
+	scalaState.setProperty(kbmId, kbm, nullptr);
+	scalaState.removeChild(scalaState.getChildWithName(mappingType), nullptr);
+}
+
+juce::String ScalaState::getScaleText(const juce::ValueTree& scalaState)
+{
+	return scalaState.getProperty(sclId).toString();
+}
+
+juce::String ScalaState::getKeyboardMappingText(const juce::ValueTree& scalaState)
+{
+	return scalaState.getProperty(kbmId).toString();
+}
+
+juce::String ScalaState::loadScale(const juce::ValueTree& scalaState, ScalaScale& scale)
+{
+	scale.clear();
+	const juce::String scl = getScaleText(scalaState);
+	if (scl.isEmpty())
+		return {};
+
+	std::string error = scale.parseScale(scl.toStdString());
+	if (error.empty())
+	{
+		const juce::String kbm = getKeyboardMappingText(scalaState);
+		if (kbm.isNotEmpty())
+			error = scale.parseKeyboardMapping(kbm.toStdString());
+	}
+	if (!error.empty())
+		scale.clear();
+	return error;
+}
+
+// The scale hash is stored as a hex string because var has no unsigned 64 bit type
+std::optional<ScalaMapping> ScalaState::loadMapping(const juce::ValueTree& scalaState)
+{
+	const juce::ValueTree mapping = scalaState.getChildWithName(mappingType);
+	if (!mapping.isValid())
+		return std::nullopt;
+
+	std::vector<ScaleDegreeMapping> degrees;
+	degrees.reserve((size_t)mapping.getNumChildren());
+	for (const juce::ValueTree& degree : mapping)
+	{
+		degrees.push_back(ScaleDegreeMapping{
+			(int)degree.getProperty(degreeId),
+			(int32_t)(int)degree.getProperty(keyId),
+			{ (int)degree.getProperty(factor3Id), (int)degree.getProperty(factor5Id), (int)degree.getProperty(factor7Id) },
+			(double)degree.getProperty(errorId) });
+	}
+
+	return ScalaMapping(
+		(uint64_t)mapping.getProperty(scaleHashId).toString().getHexValue64(),
+		(double)mapping.getProperty(semisFactor3Id),
+		(double)mapping.getProperty(semisFactor5Id),
+		(double)mapping.getProperty(semisFactor7Id),
+		std::move(degrees));
+}
+
+void ScalaState::storeMapping(juce::ValueTree& scalaState, const ScalaMapping& scalaMapping)
+{
+	juce::ValueTree mapping(mappingType);
+	mapping.setProperty(scaleHashId, juce::String::toHexString((juce::int64)scalaMapping.getScaleHash()), nullptr);
+	mapping.setProperty(semisFactor3Id, scalaMapping.getSemisFactor3(), nullptr);
+	mapping.setProperty(semisFactor5Id, scalaMapping.getSemisFactor5(), nullptr);
+	mapping.setProperty(semisFactor7Id, scalaMapping.getSemisFactor7(), nullptr);
+	for (const ScaleDegreeMapping& degreeMapping : scalaMapping.getDegrees())
+	{
+		juce::ValueTree degree(degreeType);
+		degree.setProperty(degreeId, degreeMapping.degree, nullptr);
+		degree.setProperty(keyId, (int)degreeMapping.pitchClassKey, nullptr);
+		degree.setProperty(factor3Id, degreeMapping.coordinates.factor3, nullptr);
+		degree.setProperty(factor5Id, degreeMapping.coordinates.factor5, nullptr);
+		degree.setProperty(factor7Id, degreeMapping.coordinates.factor7, nullptr);
+		degree.setProperty(errorId, degreeMapping.errorCents, nullptr);
+		mapping.appendChild(degree, nullptr);
+	}
+
+	scalaState.removeChild(scalaState.getChildWithName(mappingType), nullptr);
+	scalaState.appendChild(mapping, nullptr);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <optional>
+
+#include "ScalaMapping.h"
+#include "ScalaScale.h"
+
+// Keeps the imported Scala files and their last solved ScalaMapping in a child of the
+// processor's parameter state, so they are saved and restored with the apvts XML. The
+// mapping is only stored into the copy that gets saved.
+// Message thread only, apart from storing into that copy.
+namespace ScalaState
+{
+	// The Scala child of the parameter state, created if missing
+	juce::ValueTree get(juce::ValueTree& parameterState);
+	// Replaces the files and drops the cached mapping. Pass an empty .kbm for the default root.
+	void setFiles(juce::ValueTree& scalaState, const juce::String& scl, const juce::String& kbm);
+	juce::String getScaleText(const juce::ValueTree& scalaState);
+	juce::String getKeyboardMappingText(const juce::ValueTree& scalaState);
+	// The stored scale, empty if there is none. Returns a description of the problem if the
+	// stored files don't parse.
+	juce::String loadScale(const juce::ValueTree& scalaState, ScalaScale&);
+	std::optional<ScalaMapping> loadMapping(const juce::ValueTree& scalaState);
+	void storeMapping(juce::ValueTree& scalaState, const ScalaMapping&);
+}
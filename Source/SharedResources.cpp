@@ -0,0 +1,44 @@
+#include "SharedResources.h"
+
+SharedResources::SharedResources()
+{
+	// Process-wide anyway, so it's set once rather than by every editor
+	juce::LookAndFeel::getDefaultLookAndFeel().setDefaultSansSerifTypefaceName("Helvetica");
+}
+
+LabelImageCache& SharedResources::getLabelImageCache()
+{
+	return labelImageCache;
+}
+
+std::shared_ptr<const DescriptorTable> SharedResources::getDescriptorTable(
+	const std::vector<LatticeCoordinates>& cellBases, const TuningParameters& tuning,
+	const DescriptorTable* previous, const ScalaMapping* scale)
+{
+	const double waitStartMs = juce::Time::getMillisecondCounterHiRes();
+	const juce::ScopedLock lock(descriptorTablesLock);
+	lockWait.record((juce::Time::getMillisecondCounterHiRes() - waitStartMs) * 1000.0);
+
+	for (auto it = descriptorTables.begin(); it != descriptorTables.end(); ++it)
+	{
+		if ((*it)->isBuiltFrom(cellBases, tuning))
+		{
+			std::shared_ptr<const DescriptorTable> table = *it;
+			descriptorTables.erase(it);
+			descriptorTables.push_back(table);
+			return table;
+		}
+	}
+
+	// Built under the lock, so two editors asking for the same new tuning build it only once
+	std::shared_ptr<const DescriptorTable> table = DescriptorTable::build(cellBases, tuning, previous, scale);
+	if (descriptorTables.size() >= maxDescriptorTables)
+		descriptorTables.erase(descriptorTables.begin());
+	descriptorTables.push_back(table);
+	return table;
+}
+
+const LogHistogram& SharedResources::getLockWait() const
+{
+	return lockWait;
+}
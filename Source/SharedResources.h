@@ -0,0 +1,46 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+#include <vector>
+
+#include "DescriptorTable.h"
+#include "LabelImageCache.h"
+#include "PerformanceCounters.h"
+
+class ScalaMapping;
+
+// Caches shared by every MidiVis editor in the process, so a session with one instance per
+// track renders each label and builds each tuning's descriptors once.
+//
+// Held through juce::SharedResourcePointer<SharedResources>: the first editor to open creates
+// it, under JUCE's lock, and the last one to close frees it.
+class SharedResources
+{
+public:
+	// Descriptor tables kept for reuse, most recently used last. Covers flipping between presets
+	// in one editor as well as several instances on the same tuning.
+	static constexpr size_t maxDescriptorTables = 32;
+
+	SharedResources();
+
+	// Message thread only, like all painting
+	LabelImageCache& getLabelImageCache();
+
+	// The table for the cell bases, tuning and scale, built from previous if no editor has it yet.
+	// Any thread.
+	std::shared_ptr<const DescriptorTable> getDescriptorTable(
+		const std::vector<LatticeCoordinates>& cellBases, const TuningParameters&,
+		const DescriptorTable* previous, const ScalaMapping* scale);
+	// Time spent waiting for the descriptor tables, in microseconds, recorded by whoever got them
+	const LogHistogram& getLockWait() const;
+private:
+	LabelImageCache labelImageCache;
+
+	juce::CriticalSection descriptorTablesLock;
+	// Only recorded into while holding the lock
+	LogHistogram lockWait;
+	std::vector<std::shared_ptr<const DescriptorTable>> descriptorTables;
+
+	JUCE_DECLARE_NON_COPYABLE(SharedResources)
+};
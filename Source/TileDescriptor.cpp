@@ -0,0 +1,112 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "TileDescriptor.h"
+#include "Pitch.h"
+
+namespace {
+const char* const letterNames[] = { "F", "C", "G", "D", "A", "E", "B" };
+
+const std::string flatSign = "b";
+const std::string sharpSign = "#";
+
+const std::string syntonicCommaUpSign = "+";
+const std::string syntonicCommaDownSign = "-";
+}
+
+TileDescriptor::TileDescriptor() :
+	pitchClass(0),
+	tolerance(0),
+	meantone(false),
+	duplicate(false),
+	outsideLattice(false)
+{
+}
+
+TileDescriptor TileDescriptor::create(
+	int factor3, int factor5, int factor7, int factor11,
+	double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11,
+	double tolerance)
+{
+	TileDescriptor descriptor;
+	descriptor.tolerance = tolerance;
+	descriptor.pitchClass = PitchClass(Pitch(semisFactor3 * factor3 + semisFactor5 * factor5
+		+ semisFactor7 * factor7 + semisFactor11 * factor11));
+
+	descriptor.meantone = isMeantone(semisFactor3, semisFactor5);
+
+	descriptor.setLetterName(factor3, factor5, factor7, factor11);
+	descriptor.semitones = formatSemitones(descriptor.pitchClass);
+
+	return descriptor;
+}
+
+bool TileDescriptor::isMeantone(double semisFactor3, double semisFactor5)
+{
+	return fabs(fmod(semisFactor3 * 4, 12.0) - semisFactor5) < 0.00001;
+}
+
+void TileDescriptor::setLetterName(int factor3, int factor5, int factor7, int factor11)
+{
+	// plus one because we start at C, not F
+	int numFifths = 1 + factor3 + 4 * factor5 - 2 * factor7 - factor11;
+	int letterNameIndex = numFifths % 7;
+	if (letterNameIndex < 0) letterNameIndex += 7;
+	int semiOffset = numFifths / 7;
+	pitchName = letterNames[letterNameIndex];
+
+	accidentals.clear();
+	if (semiOffset > 0) {
+		if (semiOffset >= 1) accidentals += sharpSign;
+		if (semiOffset == 2) accidentals += sharpSign;
+		else if (semiOffset > 2) accidentals += std::to_string(semiOffset);
+	}
+	else if (numFifths < 0)
+	{
+		if (semiOffset <= 0) accidentals += flatSign;
+		if (semiOffset == -1) accidentals += flatSign;
+		else if (semiOffset < -1) accidentals += std::to_string(std::abs(semiOffset) + 1);
+	}
+
+	syntonicCommas.clear();
+	if (!meantone)
+	{
+		int syntonicCommaOffset = -factor5;
+
+		if (syntonicCommaOffset > 0) {
+			if (syntonicCommaOffset >= 1) syntonicCommas += syntonicCommaUpSign;
+			if (syntonicCommaOffset == 2) syntonicCommas += syntonicCommaUpSign;
+			else if (syntonicCommaOffset > 2) syntonicCommas += std::to_string(syntonicCommaOffset);
+		}
+		else if (syntonicCommaOffset < 0)
+		{
+			if (syntonicCommaOffset <= -1) syntonicCommas += syntonicCommaDownSign;
+			if (syntonicCommaOffset == -2) syntonicCommas += syntonicCommaDownSign;
+			else if (syntonicCommaOffset < -2) syntonicCommas += std::to_string(std::abs(syntonicCommaOffset));
+		}
+	}
+}
+
+std::string TileDescriptor::formatSemitones(const PitchClass& pitchClass)
+{
+	char semitones[16];
+	std::snprintf(semitones, sizeof(semitones), "%.2f", pitchClass.getCents() / 100.0);
+	return semitones;
+}
+
+bool TileDescriptor::hasSameLabel(const TileDescriptor& other) const
+{
+	return pitchClass == other.pitchClass
+		&& pitchName == other.pitchName
+		&& accidentals == other.accidentals
+		&& syntonicCommas == other.syntonicCommas
+		&& semitones == other.semitones
+		&& duplicate == other.duplicate
+		&& outsideLattice == other.outsideLattice;
+}
+
+bool TileDescriptor::isCulled() const
+{
+	return outsideLattice || duplicate;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+#include "PitchClass.h"
+
+// Everything a lattice cell displays that depends only on its lattice position and the tuning:
+// its pitch class and the note name, accidentals, syntonic commas and semitones label.
+class TileDescriptor
+{
+public:
+	TileDescriptor();
+	static TileDescriptor create(
+		int factor3, int factor5, int factor7, int factor11,
+		double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11,
+		double tolerance);
+
+	// Whether the visible parts of the two descriptors are identical
+	bool hasSameLabel(const TileDescriptor&) const;
+	// Whether the cell is neither lit nor drawn
+	bool isCulled() const;
+
+	// Whether four fifths make a major third, in which case syntonic commas aren't shown
+	static bool isMeantone(double semisFactor3, double semisFactor5);
+	static std::string formatSemitones(const PitchClass&);
+	// Sets pitchName, accidentals and syntonicCommas from the lattice position. Needs meantone set.
+	// Harmonic sevenths are spelled as minor sevenths and undecimal tritones as fourths.
+	void setLetterName(int factor3, int factor5, int factor7, int factor11);
+
+	PitchClass pitchClass;
+	double tolerance;
+	std::string pitchName;
+	std::string accidentals;
+	std::string syntonicCommas;
+	std::string semitones;
+	bool meantone;
+	// A corner cell repeating a pitch class on the plane, see LatticeProjection::isDepthOnPlane
+	bool duplicate;
+	// Past DescriptorTable's extent, so the cell is blank
+	bool outsideLattice;
+};
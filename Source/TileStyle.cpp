@@ -0,0 +1,63 @@
+#include "TileStyle.h"
+
+namespace {
+const float ghostBrightness = 0.22f;
+
+uint8_t quantizeIntensity(double intensity)
+{
+	return (uint8_t)juce::roundToInt(juce::jlimit(0.0, 1.0, intensity) * 255.0);
+}
+}
+
+TileStyle::VisualState TileStyle::getVisualState(const PitchInfo& intensity)
+{
+	return VisualState{
+		quantizeIntensity(intensity.noteIntensity),
+		quantizeIntensity(intensity.topIntensity),
+		quantizeIntensity(intensity.bassIntensity) };
+}
+
+juce::Colour TileStyle::getBackgroundColour(double noteIntensity)
+{
+	return juce::Colour(
+		0.6f,
+		0.4f,
+		std::fmin(ghostBrightness, std::powf((float)noteIntensity * 6, 1.5f)),
+		1.f);
+}
+
+juce::Colour TileStyle::getHeldColour(double noteIntensity)
+{
+	return juce::Colour(0.6f, 0.5f, 0.5f, 10.f * ((float)noteIntensity - 0.9f));
+}
+
+juce::Colour TileStyle::getBassColour(double bassIntensity)
+{
+	return juce::Colour(0.6f, 0.5f, 0.9f, (float)bassIntensity);
+}
+
+juce::Colour TileStyle::getTopColour(double topIntensity)
+{
+	return juce::Colour(0.6f, 0.2f, 1.f, (float)topIntensity);
+}
+
+juce::Colour TileStyle::getOutlineColour()
+{
+	return juce::Colour(0.6f, 0.5f, 0.9f, 1.f);
+}
+
+TileStyle::LabelLayout TileStyle::getLabelLayout(int width, int height)
+{
+	const int noteNameWidth = width * 0.35;
+	const int noteNameHeight = height * 0.7;
+
+	LabelLayout layout;
+	layout.pitchName = juce::Rectangle<int>(0, 0, noteNameWidth, noteNameHeight);
+	layout.accidentals = juce::Rectangle<int>(noteNameWidth + 2, noteNameHeight * 0.05, noteNameWidth - 2, noteNameHeight * 0.5);
+	layout.syntonicCommas = juce::Rectangle<int>(noteNameWidth + 2, noteNameHeight * 0.45, noteNameWidth - 2, noteNameHeight * 0.5);
+	layout.semitones = juce::Rectangle<int>(5, noteNameHeight - height * 0.1, width - 25, height - noteNameHeight);
+	layout.pitchNameFontHeight = noteNameHeight * 0.6f;
+	layout.accidentalsFontHeight = noteNameHeight * 0.6f * 0.55f;
+	layout.semitonesFontHeight = noteNameHeight * 0.35f;
+	return layout;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PitchInfo.h"
+
+// Colours and geometry shared by PitchClassTile and the batched LatticeRenderer,
+// so both renderers draw identical tiles.
+namespace TileStyle
+{
+	constexpr int borderSize = 1;
+	constexpr int outerRingOffset = borderSize + 5;
+	constexpr int innerRingOffset = borderSize + 10;
+
+	// Notes above this intensity get the brighter held overlay
+	constexpr double heldThreshold = 0.9;
+
+	// What a tile was last asked to show. Intensities are quantized to the 8 bits
+	// the colour alpha ends up with, so sub-visible changes don't trigger repaints.
+	struct VisualState
+	{
+		uint8_t note;
+		uint8_t top;
+		uint8_t bass;
+		bool operator==(const VisualState&) const = default;
+	};
+
+	VisualState getVisualState(const PitchInfo&);
+
+	juce::Colour getBackgroundColour(double noteIntensity);
+	juce::Colour getHeldColour(double noteIntensity);
+	juce::Colour getBassColour(double bassIntensity);
+	juce::Colour getTopColour(double topIntensity);
+	juce::Colour getOutlineColour();
+
+	struct LabelLayout
+	{
+		juce::Rectangle<int> pitchName;
+		juce::Rectangle<int> accidentals;
+		juce::Rectangle<int> syntonicCommas;
+		juce::Rectangle<int> semitones;
+		float pitchNameFontHeight;
+		float accidentalsFontHeight;
+		float semitonesFontHeight;
+	};
+
+	// Label positions relative to the top left corner of a tile of the given size
+	LabelLayout getLabelLayout(int width, int height);
+}
@@ -0,0 +1,140 @@
+#include "TimelineView.h"
+
+TimelineView::TimelineView() :
+	nextIndex(0),
+	activityStartSeconds(0),
+	beginSeconds(0),
+	endSeconds(0)
+{
+	setOpaque(true);
+}
+
+void TimelineView::update(const PerformanceHistory& history, double nowSeconds)
+{
+	nextIndex = history.forEachEvent(nextIndex, [this](const NoteEvent& event)
+	{
+		if (event.type != NoteEvent::Type::Added)
+			return;
+		if (activity.empty())
+			activityStartSeconds = std::floor(event.timeSeconds);
+		int bin = (int)((event.timeSeconds - activityStartSeconds) / secondsPerBin);
+		if (bin < 0)
+			return;
+		if (bin >= (int)activity.size())
+			activity.resize((size_t)bin + 1, 0);
+		activity[(size_t)bin]++;
+	});
+
+	double historyEndSeconds;
+	if (history.getTimeRange(beginSeconds, historyEndSeconds))
+	{
+		endSeconds = std::max(nowSeconds, historyEndSeconds);
+
+		// Drop bins the history no longer reaches, in chunks so this isn't done every update
+		int numStaleBins = (int)((beginSeconds - activityStartSeconds) / secondsPerBin);
+		if (numStaleBins > 60)
+		{
+			numStaleBins = std::min(numStaleBins, (int)activity.size());
+			activity.erase(activity.begin(), activity.begin() + numStaleBins);
+			activityStartSeconds += numStaleBins * secondsPerBin;
+		}
+	}
+
+	repaint();
+}
+
+std::optional<double> TimelineView::getScrubTime() const
+{
+	return scrubTime;
+}
+
+void TimelineView::setLive()
+{
+	if (!scrubTime.has_value())
+		return;
+	scrubTime.reset();
+	repaint();
+	if (onScrub)
+		onScrub(scrubTime);
+}
+
+double TimelineView::xToTime(float x) const
+{
+	double proportion = juce::jlimit(0.0, 1.0, (double)x / juce::jmax(1, getWidth()));
+	return beginSeconds + proportion * (endSeconds - beginSeconds);
+}
+
+float TimelineView::timeToX(double timeSeconds) const
+{
+	if (endSeconds <= beginSeconds)
+		return (float)getWidth();
+	return (float)((timeSeconds - beginSeconds) / (endSeconds - beginSeconds) * getWidth());
+}
+
+void TimelineView::scrubTo(float x)
+{
+	if (endSeconds <= beginSeconds)
+		return;
+	scrubTime = xToTime(x);
+	repaint();
+	if (onScrub)
+		onScrub(scrubTime);
+}
+
+void TimelineView::mouseDown(const juce::MouseEvent& event)
+{
+	scrubTo(event.position.x);
+}
+
+void TimelineView::mouseDrag(const juce::MouseEvent& event)
+{
+	scrubTo(event.position.x);
+}
+
+void TimelineView::mouseDoubleClick(const juce::MouseEvent&)
+{
+	setLive();
+}
+
+void TimelineView::paint(juce::Graphics& g)
+{
+	g.fillAll(juce::Colour(0xff202020));
+
+	const int width = getWidth();
+	const float height = (float)getHeight();
+	if (endSeconds > beginSeconds && !activity.empty())
+	{
+		// Busiest bin in each pixel column, scaled to the busiest column overall
+		std::vector<uint32_t> columns((size_t)width, 0);
+		uint32_t maxActivity = 1;
+		for (size_t bin = 0; bin < activity.size(); bin++)
+		{
+			double binSeconds = activityStartSeconds + bin * secondsPerBin;
+			if (binSeconds < beginSeconds - secondsPerBin)
+				continue;
+			int x = juce::jlimit(0, width - 1, (int)timeToX(binSeconds));
+			columns[(size_t)x] = std::max(columns[(size_t)x], activity[bin]);
+			maxActivity = std::max(maxActivity, activity[bin]);
+		}
+
+		g.setColour(juce::Colour(0xff5f8fbf));
+		for (int x = 0; x < width; x++)
+		{
+			if (columns[(size_t)x] == 0)
+				continue;
+			float barHeight = height * (float)columns[(size_t)x] / (float)maxActivity;
+			g.fillRect((float)x, height - barHeight, 1.f, barHeight);
+		}
+	}
+
+	g.setColour(juce::Colours::white.withAlpha(0.7f));
+	g.setFont(12.f);
+	int spanSeconds = (int)(endSeconds - beginSeconds);
+	juce::String span = "-" + juce::String(spanSeconds / 60) + ":" + juce::String(spanSeconds % 60).paddedLeft('0', 2);
+	g.drawText(span, 4, 2, 80, 14, juce::Justification::left);
+	g.drawText(scrubTime.has_value() ? "Double click for live" : "Live", width - 124, 2, 120, 14, juce::Justification::right);
+
+	float playheadX = scrubTime.has_value() ? timeToX(*scrubTime) : (float)width - 1.f;
+	g.setColour(scrubTime.has_value() ? juce::Colours::orange : juce::Colours::white);
+	g.fillRect(playheadX - 1.f, 0.f, 2.f, height);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "PerformanceHistory.h"
+
+// Strip showing how much was played over the whole recorded history. Clicking or dragging
+// scrubs to that instant, double clicking goes back to following the live input.
+class TimelineView : public juce::Component
+{
+public:
+	TimelineView();
+	// Takes in events recorded since the last call and repaints
+	void update(const PerformanceHistory&, double nowSeconds);
+	// The instant shown, or nothing when live
+	std::optional<double> getScrubTime() const;
+	void setLive();
+	void paint(juce::Graphics&) override;
+	void mouseDown(const juce::MouseEvent&) override;
+	void mouseDrag(const juce::MouseEvent&) override;
+	void mouseDoubleClick(const juce::MouseEvent&) override;
+
+	// Called on the message thread whenever the scrub time changes
+	std::function<void(std::optional<double>)> onScrub;
+private:
+	static constexpr double secondsPerBin = 1.0;
+
+	double xToTime(float x) const;
+	float timeToX(double) const;
+	void scrubTo(float x);
+
+	uint64_t nextIndex;
+	// Note starts per bin, from activityStartSeconds on
+	std::vector<uint32_t> activity;
+	double activityStartSeconds;
+	// Span that can be scrubbed to
+	double beginSeconds;
+	double endSeconds;
+	std::optional<double> scrubTime;
+};
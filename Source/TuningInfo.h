@@ -1,4 +1,9 @@
 #pragma once
+
+// Sizes of the lattice's generating intervals, in semitones reduced to one octave.
+// The 5, 7 and 11 intervals can either be set directly or generated by a number of fifths,
+// as in meantone and other fifth-based temperaments.
+// Everything is constexpr so tuning tables can be built at compile time.
 class TuningInfo
 {
 private:
@@ -15,22 +20,56 @@ private:
 	bool factor3Generates7;
 	bool factor3Generates11;
 
+	// Reduces a stack of fifths to within one octave
+	static constexpr double reduceToOctave(double semitones)
+	{
+		while (semitones >= 12.0) semitones -= 12.0;
+		while (semitones < 0.0) semitones += 12.0;
+		return semitones;
+	}
+
 public:
-	TuningInfo(double semisFactor3,
+	constexpr TuningInfo(double semisFactor3,
 		bool factor3Generates5, int factor3To5, double semisFactor5,
 		bool factor3Generates7, int factor3To7, double semisFactor7,
-		bool factor3Generates11, int factor3To11, double semisFactor11);
+		bool factor3Generates11, int factor3To11, double semisFactor11) :
+		semisFactor3(semisFactor3),
+		semisFactor5(semisFactor5),
+		semisFactor7(semisFactor7),
+		semisFactor11(semisFactor11),
+		factor3To5(factor3To5),
+		factor3To7(factor3To7),
+		factor3To11(factor3To11),
+		factor3Generates5(factor3Generates5),
+		factor3Generates7(factor3Generates7),
+		factor3Generates11(factor3Generates11)
+	{}
+
+	constexpr double getSemisFactor3() const
+	{
+		return semisFactor3;
+	}
+
+	constexpr double getSemisFactor5() const
+	{
+		return factor3Generates5 ? reduceToOctave(factor3To5 * semisFactor3) : semisFactor5;
+	}
+
+	constexpr double getSemisFactor7() const
+	{
+		return factor3Generates7 ? reduceToOctave(factor3To7 * semisFactor3) : semisFactor7;
+	}
 
-	double getSemisFactor3();
-	double getSemisFactor5();
-	double getSemisFactor7();
-	double getSemisFactor11();
+	constexpr double getSemisFactor11() const
+	{
+		return factor3Generates11 ? reduceToOctave(factor3To11 * semisFactor3) : semisFactor11;
+	}
 
-	int getFactor3To5();
-	int getFactor3To7();
-	int getFactor3To11();
+	constexpr int getFactor3To5() const { return factor3To5; }
+	constexpr int getFactor3To7() const { return factor3To7; }
+	constexpr int getFactor3To11() const { return factor3To11; }
 
-	bool getFactor3Generates5();
-	bool getFactor3Generates7();
-	bool getFactor3Generates11();
+	constexpr bool getFactor3Generates5() const { return factor3Generates5; }
+	constexpr bool getFactor3Generates7() const { return factor3Generates7; }
+	constexpr bool getFactor3Generates11() const { return factor3Generates11; }
 };
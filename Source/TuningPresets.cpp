@@ -0,0 +1,43 @@
+#include <cmath>
+
+#include "TuningPresets.h"
+
+namespace {
+// Every preset has to be reachable with PluginProcessor's parameter ranges
+constexpr bool isWithinParameterRanges(const TuningInfo& tuning)
+{
+	return tuning.getSemisFactor3() >= 6.8 && tuning.getSemisFactor3() <= 7.2
+		&& tuning.getSemisFactor5() >= 3.8 && tuning.getSemisFactor5() <= 4.2
+		&& tuning.getSemisFactor7() >= 9.6 && tuning.getSemisFactor7() <= 10.0
+		&& tuning.getSemisFactor11() >= 5.0 && tuning.getSemisFactor11() <= 6.0;
+}
+
+constexpr bool allWithinParameterRanges()
+{
+	for (const TuningPreset& preset : TuningPresets::presets)
+	{
+		if (!isWithinParameterRanges(preset.tuning))
+			return false;
+	}
+	return true;
+}
+
+static_assert(allWithinParameterRanges(), "A tuning preset is outside the parameter ranges");
+
+// Parameters are stored as floats, so allow for their rounding
+const double matchTolerance = 0.0001;
+}
+
+int TuningPresets::find(double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11)
+{
+	for (int i = 0; i < (int)presets.size(); i++)
+	{
+		const TuningInfo& tuning = presets[i].tuning;
+		if (std::abs(tuning.getSemisFactor3() - semisFactor3) < matchTolerance
+			&& std::abs(tuning.getSemisFactor5() - semisFactor5) < matchTolerance
+			&& std::abs(tuning.getSemisFactor7() - semisFactor7) < matchTolerance
+			&& std::abs(tuning.getSemisFactor11() - semisFactor11) < matchTolerance)
+			return i;
+	}
+	return -1;
+}
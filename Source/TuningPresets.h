@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+
+#include "TuningInfo.h"
+
+struct TuningPreset
+{
+	const char* name;
+	TuningInfo tuning;
+};
+
+// Built-in EDOs and temperaments. The interval tables are computed at compile time,
+// so switching presets is a lookup.
+namespace TuningPresets
+{
+	namespace Cents
+	{
+		constexpr double justFifth = 701.9550009;
+		constexpr double justMajorThird = 386.3137139;
+		constexpr double harmonicSeventh = 968.8259065;
+		constexpr double undecimalTritone = 551.3179424;
+		constexpr double syntonicComma = 21.5062896;
+		constexpr double schisma = 1.9537208;
+	}
+
+	// Every interval given directly as a number of steps of the EDO
+	constexpr TuningInfo edo(int divisions, int fifth, int majorThird, int harmonicSeventh, int undecimalTritone)
+	{
+		return TuningInfo(12.0 * fifth / divisions,
+			false, 0, 12.0 * majorThird / divisions,
+			false, 0, 12.0 * harmonicSeventh / divisions,
+			false, 0, 12.0 * undecimalTritone / divisions);
+	}
+
+	// Fifth narrowed by a fraction of the syntonic comma. Thirds are four fifths, sevenths
+	// ten (augmented sixth) and 11/8 is thirteen fifths down, as in septimal meantone.
+	constexpr TuningInfo meantone(double commaFraction, bool generateSeventh = true)
+	{
+		return TuningInfo((Cents::justFifth - Cents::syntonicComma * commaFraction) * 0.01,
+			true, 4, 0,
+			generateSeventh, 10, Cents::harmonicSeventh * 0.01,
+			true, -13, 0);
+	}
+
+	constexpr std::array<TuningPreset, 12> presets = { {
+		{ "12-EDO", edo(12, 7, 4, 10, 6) },
+		{ "22-EDO", edo(22, 13, 7, 18, 10) },
+		{ "31-EDO", edo(31, 18, 10, 25, 14) },
+		{ "41-EDO", edo(41, 24, 13, 33, 19) },
+		{ "53-EDO", edo(53, 31, 17, 43, 24) },
+		{ "72-EDO", edo(72, 42, 23, 58, 33) },
+		{ "1/4-comma meantone", meantone(1.0 / 4.0) },
+		{ "1/6-comma meantone", meantone(1.0 / 6.0) },
+		// Ten of its fifths make a seventh below the seventh slider's range, so it gets a just one
+		{ "2/7-comma meantone", meantone(2.0 / 7.0, false) },
+		// The seventh is the Pythagorean minor seventh, two fifths down
+		{ "Pythagorean", TuningInfo(Cents::justFifth * 0.01,
+			true, 4, 0,
+			true, -2, 0,
+			false, 0, Cents::undecimalTritone * 0.01) },
+		// Eight fifths down make the major third, fourteen the seventh
+		{ "Schismatic (Helmholtz)", TuningInfo((Cents::justFifth - Cents::schisma / 8.0) * 0.01,
+			true, -8, 0,
+			true, -14, 0,
+			false, 0, Cents::undecimalTritone * 0.01) },
+		{ "11-limit just intonation", TuningInfo(Cents::justFifth * 0.01,
+			false, 0, Cents::justMajorThird * 0.01,
+			false, 0, Cents::harmonicSeventh * 0.01,
+			false, 0, Cents::undecimalTritone * 0.01) },
+	} };
+
+	// Index of the preset matching the given intervals (in semitones), or -1
+	int find(double semisFactor3, double semisFactor5, double semisFactor7, double semisFactor11);
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+
+#include "VoiceTable.h"
+
+VoiceTable::VoiceTable() : numVoices(0), heldPitches(), numHeldPitches(0), numDropped(0)
+{
+	for (Slot& slot : slots)
+		slot.key = emptyKey;
+}
+
+uint32_t VoiceTable::makeKey(uint8_t midiChannel, uint16_t noteID)
+{
+	return (uint32_t)midiChannel << 16 | noteID;
+}
+
+uint32_t VoiceTable::getHomeSlot(uint32_t key)
+{
+	// Fibonacci hashing spreads consecutive noteIDs over the table
+	return (key * 2654435769u) >> 20 & slotMask;
+}
+
+// Slot holding the key, or the empty slot where it would go
+uint32_t VoiceTable::findSlot(uint32_t key) const
+{
+	uint32_t slot = getHomeSlot(key);
+	while (slots[slot].key != key && slots[slot].key != emptyKey)
+		slot = (slot + 1) & slotMask;
+	return slot;
+}
+
+// Backward-shift deletion, so lookups never need tombstones
+void VoiceTable::eraseSlot(uint32_t slot)
+{
+	uint32_t next = (slot + 1) & slotMask;
+	while (slots[next].key != emptyKey)
+	{
+		const uint32_t home = getHomeSlot(slots[next].key);
+		// Move the entry back if its home isn't cyclically within (slot, next]
+		if (((next - home) & slotMask) >= ((next - slot) & slotMask))
+		{
+			slots[slot] = slots[next];
+			slot = next;
+		}
+		next = (next + 1) & slotMask;
+	}
+	slots[slot].key = emptyKey;
+}
+
+std::optional<Pitch> VoiceTable::find(uint8_t midiChannel, uint16_t noteID) const
+{
+	const Slot& slot = slots[findSlot(makeKey(midiChannel, noteID))];
+	if (slot.key == emptyKey)
+		return std::nullopt;
+	return Pitch::fromKey(slot.pitchKey);
+}
+
+bool VoiceTable::add(uint8_t midiChannel, uint16_t noteID, const Pitch& pitch)
+{
+	const uint32_t key = makeKey(midiChannel, noteID);
+	Slot& slot = slots[findSlot(key)];
+
+	if (slot.key == key)
+	{
+		removeHeldPitch(Pitch::fromKey(slot.pitchKey));
+	}
+	else
+	{
+		if (numVoices >= capacity)
+		{
+			numDropped++;
+			return false;
+		}
+		slot.key = key;
+		numVoices++;
+	}
+
+	slot.pitchKey = pitch.getKey();
+	addHeldPitch(pitch);
+	return true;
+}
+
+std::optional<Pitch> VoiceTable::remove(uint8_t midiChannel, uint16_t noteID)
+{
+	const uint32_t slot = findSlot(makeKey(midiChannel, noteID));
+	if (slots[slot].key == emptyKey)
+		return std::nullopt;
+
+	const Pitch pitch = Pitch::fromKey(slots[slot].pitchKey);
+	eraseSlot(slot);
+	numVoices--;
+	removeHeldPitch(pitch);
+	return pitch;
+}
+
+int VoiceTable::lowerBound(int32_t pitchKey) const
+{
+	return (int)(std::lower_bound(heldPitches.begin(), heldPitches.begin() + numHeldPitches, pitchKey,
+		[](const HeldPitch& held, int32_t key) { return held.pitchKey < key; })
+		- heldPitches.begin());
+}
+
+void VoiceTable::addHeldPitch(const Pitch& pitch)
+{
+	const int index = lowerBound(pitch.getKey());
+	if (index < numHeldPitches && heldPitches[index].pitchKey == pitch.getKey())
+	{
+		heldPitches[index].numVoices++;
+		return;
+	}
+
+	std::copy_backward(heldPitches.begin() + index, heldPitches.begin() + numHeldPitches,
+		heldPitches.begin() + numHeldPitches + 1);
+	heldPitches[index] = HeldPitch{ pitch.getKey(), 1 };
+	numHeldPitches++;
+}
+
+void VoiceTable::removeHeldPitch(const Pitch& pitch)
+{
+	const int index = lowerBound(pitch.getKey());
+	if (index >= numHeldPitches || !(heldPitches[index].pitchKey == pitch.getKey()))
+		return;
+
+	if (--heldPitches[index].numVoices > 0)
+		return;
+
+	std::copy(heldPitches.begin() + index + 1, heldPitches.begin() + numHeldPitches,
+		heldPitches.begin() + index);
+	numHeldPitches--;
+}
+
+bool VoiceTable::isHeld(const Pitch& pitch) const
+{
+	const int index = lowerBound(pitch.getKey());
+	return index < numHeldPitches && heldPitches[index].pitchKey == pitch.getKey();
+}
+
+std::optional<Pitch> VoiceTable::getLowest() const
+{
+	if (numHeldPitches == 0)
+		return std::nullopt;
+	return Pitch::fromKey(heldPitches[0].pitchKey);
+}
+
+std::optional<Pitch> VoiceTable::getHighest() const
+{
+	if (numHeldPitches == 0)
+		return std::nullopt;
+	return Pitch::fromKey(heldPitches[numHeldPitches - 1].pitchKey);
+}
+
+int VoiceTable::getNumVoices() const
+{
+	return numVoices;
+}
+
+int VoiceTable::getNumHeldPitches() const
+{
+	return numHeldPitches;
+}
+
+Pitch VoiceTable::getHeldPitch(int index) const
+{
+	return Pitch::fromKey(heldPitches[index].pitchKey);
+}
+
+uint32_t VoiceTable::getNumDropped() const
+{
+	return numDropped;
+}
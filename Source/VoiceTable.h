@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "Pitch.h"
+
+// Sounding voices keyed by MIDI channel and MPE noteID, plus the held pitches in sorted order
+// with how many voices hold each, so the lowest and highest held pitch are always at hand.
+// Fixed capacity: never allocates after construction. Voices beyond capacity are dropped and counted.
+class VoiceTable
+{
+public:
+	static constexpr int capacity = 2048;
+
+	VoiceTable();
+	// Pitch of a sounding voice
+	std::optional<Pitch> find(uint8_t midiChannel, uint16_t noteID) const;
+	// Starts a voice, or moves it to a new pitch. Returns false if the table is full.
+	bool add(uint8_t midiChannel, uint16_t noteID, const Pitch&);
+	// Stops a voice and returns the pitch it had
+	std::optional<Pitch> remove(uint8_t midiChannel, uint16_t noteID);
+	// Whether any voice holds the pitch
+	bool isHeld(const Pitch&) const;
+	std::optional<Pitch> getLowest() const;
+	std::optional<Pitch> getHighest() const;
+	int getNumVoices() const;
+	int getNumHeldPitches() const;
+	// Held pitch by index, lowest first
+	Pitch getHeldPitch(int) const;
+	uint32_t getNumDropped() const;
+	// Calls callback(midiChannel, noteID, pitch) for every sounding voice, in no particular order
+	template <typename Callback>
+	void forEachVoice(Callback&&) const;
+private:
+	// Open addressing with linear probing, at most half full
+	static constexpr uint32_t numSlots = capacity * 2;
+	static constexpr uint32_t slotMask = numSlots - 1;
+	static constexpr uint32_t emptyKey = 0xffffffff;
+
+	struct Slot
+	{
+		uint32_t key;
+		int32_t pitchKey;
+	};
+
+	struct HeldPitch
+	{
+		int32_t pitchKey;
+		uint32_t numVoices;
+	};
+
+	static uint32_t makeKey(uint8_t midiChannel, uint16_t noteID);
+	static uint32_t getHomeSlot(uint32_t key);
+	uint32_t findSlot(uint32_t key) const;
+	void eraseSlot(uint32_t slot);
+	int lowerBound(int32_t pitchKey) const;
+	void addHeldPitch(const Pitch&);
+	void removeHeldPitch(const Pitch&);
+
+	std::array<Slot, numSlots> slots;
+	int numVoices;
+	// Sorted by pitch. Every voice holds exactly one entry, so capacity entries always suffice.
+	std::array<HeldPitch, capacity> heldPitches;
+	int numHeldPitches;
+	uint32_t numDropped;
+};
+
+template <typename Callback>
+void VoiceTable::forEachVoice(Callback&& callback) const
+{
+	for (const Slot& slot : slots)
+	{
+		if (slot.key != emptyKey)
+			callback((uint8_t)(slot.key >> 16), (uint16_t)(slot.key & 0xffff), Pitch::fromKey(slot.pitchKey));
+	}
+}